@@ -13,10 +13,16 @@ void main()
 #version 330 core
 layout(location = 0) out vec4 color;
 in vec2 v_TexCoord;
-uniform vec4 u_Color;
+#include "Material.glsl"
 uniform sampler2D u_Texture;
 void main()
 {
+#if defined(NO_TEXTURE)
+	color = u_Color;
+#elif defined(NO_COLOR)
+	color = texture(u_Texture, v_TexCoord);
+#else
 	vec4 texColor = texture(u_Texture, v_TexCoord);
 	color = texColor * u_Color;
-};
\ No newline at end of file
+#endif
+};
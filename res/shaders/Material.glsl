@@ -0,0 +1,4 @@
+layout(std140) uniform Material
+{
+	vec4 u_Color;
+};
@@ -24,6 +24,20 @@
 #include "VertexArray.h"
 #include "Shader.h"
 #include "Texture.h"
+#include "PipelineState.h"
+#include "Material.h"
+#include "ProgramBinaryCache.h"
+#include "ShaderLibrary.h"
+#include "TransformSystem.h"
+#include "Frustum.h"
+#include "OcclusionCuller.h"
+#include "JobSystem.h"
+#include "RenderThread.h"
+#include "ResourceFactory.h"
+#include "UploadThread.h"
+#include "AssetPack.h"
+#include "AsyncFileReader.h"
+#include "AssetLoader.h"
 // OpenGL Mathematics
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -72,8 +86,6 @@ int main(void)
         std::cout << "Error!" << std::endl;
     /* Define viewpoint dimensions */
     glViewport(0, 0, screenWidth, screenHeight);
-    /* Here glEnable() enables depth */
-    glEnable(GL_DEPTH_TEST);
 
     std::cout << glGetString(GL_VERSION) << std::endl;
     {
@@ -130,10 +142,6 @@ int main(void)
         };
         */
 
-        /* Defines how openGL is going to blend alpha */
-        GLCall(glEnable(GL_BLEND));
-        GLCall(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));  //src alpha = 0; dest = 1 - 0 = 0
-
         VertexArray va;
         VertexBuffer vb(positions, sizeof(positions)); // expand the buffer to 4 elements per vertex
 
@@ -142,16 +150,59 @@ int main(void)
         layout.Push<float>(2);  // Texture positions size
         va.AddBuffer(vb, layout);
 
-        Shader shader("res/shaders/Basic.shader");
-        shader.Bind();
-        shader.SetUniform4f("u_Color", 0.2f, 0.3f, 0.8f, 1.0f);
+        /* Linked programs are cached on disk so warm starts skip shader compilation */
+        ProgramBinaryCache programCache("cache/programs");
+        /* All shaders are submitted at once so the driver can compile them in parallel */
+        ShaderLibrary shaders(&programCache);
+#ifdef EMBED_SHADERS
+        /* Deployment builds use the copies compiled into the executable */
+        shaders.LoadEmbedded();
+#else
+        shaders.LoadDirectory("res/shaders");
+        shaders.EnableHotReload("res/shaders");
+#endif
+        Shader& shader = shaders.Get("Basic");
+
+        /* Worker threads for the frame work, this thread is worker 0 */
+        JobSystem jobs;
+        /* GL objects requested by loader threads, created on the render thread within a budget */
+        ResourceFactory resources;
+        const double resourceBudgetMilliseconds = 2.0;
+        /* Asset files are read in batches by a dedicated I/O thread */
+        AsyncFileReader files;
+        /* Textures are decoded on the workers; the context is still current
+           here, so waiting also creates the GL objects the loads ask for */
+        AssetLoader assets(jobs, resources, files);
+        /* Deployments ship the cooked assets as one pack, see tools/CookAssets.cpp */
+        AssetPack pack;
+        if (pack.Open("res.pack"))
+            assets.Mount(&pack);
+        Task<std::shared_ptr<Texture>> textureLoad = assets.LoadTexture("res/textures/rainbow.png");
+        std::shared_ptr<Texture> texture = assets.Wait(textureLoad, true);
+        ASSERT(texture);
+
+        /* Cube material: color parameter block plus the texture in slot 0 */
+        MaterialLibrary materials;
+        MaterialLayout cubeLayout;
+        cubeLayout.Push<glm::vec4>("u_Color");
+        Material& cubeMaterial = materials.Create(shader, cubeLayout);
+        cubeMaterial.Set("u_Color", glm::vec4(0.2f, 0.3f, 0.8f, 1.0f));
+        cubeMaterial.SetTexture(0, *texture, "u_Texture");  //the slot is 0
 
         va.Unbind();
         vb.Unbind();    //GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
-        shader.UnBind();  //GLCall(glUseProgram(0));
 
         Renderer renderer;
 
+        /* Pipeline state of the cube: depth test on and alpha blending */
+        PipelineStateCache pipelineCache;
+        PipelineStateDesc cubeDesc;
+        cubeDesc.Program = &shader;
+        cubeDesc.VertexInput = &va;
+        cubeDesc.Blend = { true, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_FUNC_ADD };  //src alpha = 0; dest = 1 - 0 = 0
+        cubeDesc.Depth = { true, true, GL_LESS };
+        const PipelineState& cubePipeline = pipelineCache.Get(cubeDesc);
+
         /* to create the animation of color change */
         float r = 0.0f;
         float incrementC = 0.03f;
@@ -165,32 +216,89 @@ int main(void)
         glm::mat4 projection;
         projection = glm::perspective(45.0f, (GLfloat)screenWidth / (GLfloat)screenHeight, 0.1f, 100.0f);;
 
-        /* Loop until the user closes the window, to render continusely */
-        while (!glfwWindowShouldClose(window))
+        /* Object transforms, composed for all objects at once every frame */
+        TransformSystem transforms;
+        unsigned int cube = transforms.Create(glm::vec3(x, 0.0f, -3.0f));
+
+        /* World bounds of every object, culled against the view frustum before submission */
+        const AABB cubeBounds = { glm::vec3(-0.5f), glm::vec3(0.5f) };
+        AABBArray worldBounds;
+        worldBounds.Add(cubeBounds);
+        std::vector<unsigned int> visible;
+        /* The solid cubes are occluders too, objects hidden behind them are not drawn */
+        OcclusionCuller occlusion;
+
+        /* Draws are recorded into command buffers by the workers, in chunks of this many */
+        const unsigned int recordGrain = 256;
+        std::vector<CommandBuffer> recorders;
+        UniformHandle transformUniform = shader.GetUniformHandle("transformations");
+
+        /* Large meshes and textures are uploaded through a second, shared context */
+        UploadThread uploads(window);
+
+        /* From here on the GL context belongs to the render thread: it applies the
+           recorded parameter changes and draws while the next frame is simulated */
+        glfwMakeContextCurrent(nullptr);
+        RenderThread renderThread(window, [&](const FramePacket& packet)
         {
+            /* Pick up edited shaders without restarting */
+            shaders.Update();
+            resources.Process(resourceBudgetMilliseconds);
+            uploads.Publish();
+
             /* Render here */
             renderer.Clear();  //GLCall(glClear(GL_COLOR_BUFFER_BIT));
 
-            /* Transformations */
-            glm::mat4 model;
-            glm::mat4 view;
-            glm::mat4 size;
-            model = glm::rotate(model, (GLfloat)glfwGetTime() * 1.0f, glm::vec3(0.5f, 1.0f, 0.0f));
-            view = glm::translate(view, glm::vec3(x, 0.0f, -3.0f));
-            size = glm::scale(size, glm::vec3(s, s, s));
-            glm::mat4 transformations = projection * view * model* size;
+            /* Only materials whose parameters changed are uploaded */
+            for (const ParameterWrite& write : packet.parameters)
+                write.material->SetParameter(write.name, write.value.data(), (unsigned int)write.value.size());
+            materials.Update();
 
-            // use the shader and bind the buffer and ibo each time in case that the buffer change
-            shader.Bind();   //GLCall(glUseProgram(shader));
-            shader.SetUniform4f("u_Color", r, 0.3f, 0.8f, 1.0f);   //GLCall(glUniform4f(location, r, 0.3f, 0.8f, 1.0f));
+            for (const DrawPacket& draw : packet.draws)
+                renderer.Submit(*draw.pipeline, *draw.material, draw.vertexCount, draw.transform);
+            renderer.Flush();
+            renderer.Execute(packet.commands);
+        });
 
-            shader.SetUniformMat4f("transformations", transformations);
-
-            Texture texture("res/textures/rainbow.png");
-            texture.Bind();
-            shader.SetUniform1i("u_Texture", 0);  //the slot is 0
+        /* Loop until the user closes the window, to render continusely */
+        while (!glfwWindowShouldClose(window))
+        {
+            /* Transformations: translation * rotation * scale, then the projection */
+            transforms.SetPosition(cube, glm::vec3(x, 0.0f, -3.0f));
+            transforms.SetRotation(cube, glm::angleAxis((GLfloat)glfwGetTime() * 1.0f, glm::normalize(glm::vec3(0.5f, 1.0f, 0.0f))));
+            transforms.SetScale(cube, glm::vec3(s, s, s));
+            transforms.Update(projection);
+            worldBounds.Set(cube, TransformAABB(cubeBounds, transforms.GetWorld(cube)));
+            Frustum frustum(projection);
+            frustum.Cull(worldBounds, visible);
+            occlusion.Begin();
+            for (unsigned int object : visible)
+                occlusion.AddOccluder(cubeBounds, transforms.GetMVP(object));
+            occlusion.Rasterize(&jobs);
+            occlusion.Cull(worldBounds, projection, visible);
 
-            renderer.Draw(va, shader);
+            /* Record the frame for the render thread */
+            FramePacket& packet = renderThread.BeginFrame();
+            packet.SetParameter(cubeMaterial, "u_Color", glm::vec4(r, 0.3f, 0.8f, 1.0f));
+            /* every chunk of visible objects is encoded by a worker into its own
+               buffer, the buffers are merged in order so the draw order is kept */
+            unsigned int visibleCount = (unsigned int)visible.size();
+            recorders.resize((visibleCount + recordGrain - 1) / recordGrain);
+            jobs.ParallelFor(visibleCount, recordGrain, [&](unsigned int begin, unsigned int end)
+            {
+                CommandBuffer& commands = recorders[begin / recordGrain];
+                commands.Clear();
+                for (unsigned int i = begin; i < end; i++)
+                {
+                    commands.BindPipeline(cubePipeline);
+                    commands.BindMaterial(cubeMaterial);
+                    commands.SetUniform(shader, transformUniform, transforms.GetMVP(visible[i]));
+                    commands.Draw(36);
+                }
+            });
+            for (const CommandBuffer& commands : recorders)
+                packet.commands.Append(commands);
+            renderThread.Submit();
 
             /* Color change animation */
             if (r > 1.0f)
@@ -211,12 +319,15 @@ int main(void)
                 incrementS =  0.01f;
             s += incrementS;
 
-            /* Swap front and back buffers */
-            glfwSwapBuffers(window);
-
-            /* Poll for and process events */
+            /* Poll for and process events; buffers are swapped by the render thread */
             glfwPollEvents();
         }
+
+        /* How busy every worker was over the run */
+        std::vector<WorkerStats> stats = jobs.GetStats();
+        for (unsigned int i = 0; i < stats.size(); i++)
+            std::cout << "Worker " << i << ": " << stats[i].jobs << " jobs, " << stats[i].steals << " steals, "
+                      << (int)(stats[i].utilization * 100.0) << "% busy" << std::endl;
     }
     /* glfwTerminate() Destroys all remaining windows and cursors,
        restores any modified gamma ramps and frees
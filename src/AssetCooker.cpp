@@ -0,0 +1,313 @@
+#include "AssetCooker.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_set>
+#include "AsyncFileReader.h"
+#include "Hash.h"
+#include "JobSystem.h"
+#include "ShaderPreprocessor.h"
+#include "vendor/stb_image/stb_image.h"
+
+#define COOK_DATABASE_VERSION 1
+
+AssetCooker::AssetCooker(const std::string& outputDirectory)
+    : m_OutputDirectory(outputDirectory), m_DatabasePath((std::filesystem::path(outputDirectory) / COOK_DATABASE_NAME).generic_string())
+{
+    LoadDatabase();
+}
+
+void AssetCooker::AddRecipe(const CookRecipe& recipe)
+{
+    m_Recipes.push_back(recipe);
+}
+
+static bool CookTexture(CookContext& context)
+{
+    int width = 0, height = 0, channels = 0;
+    stbi_set_flip_vertically_on_load_thread(1);
+    unsigned char* pixels = stbi_load(context.input.c_str(), &width, &height, &channels, 4);
+    if (!pixels)
+        return false;
+    CookedTextureHeader header = { COOKED_TEXTURE_MAGIC, (uint32_t)width, (uint32_t)height, 0 };
+    std::ofstream stream(context.output, std::ios::binary | std::ios::trunc);
+    stream.write((const char*)&header, sizeof(header));
+    stream.write((const char*)pixels, (std::streamsize)width * height * 4);
+    stbi_image_free(pixels);
+    return (bool)stream;
+}
+
+static bool CookShader(CookContext& context)
+{
+    std::vector<std::string> dependencies;
+    std::vector<unsigned long long> hashes;
+    std::string text = ShaderPreprocessor::ResolveIncludes(context.input, dependencies, &hashes);
+    if (text.empty())
+        return false;
+    for (size_t i = 0; i < dependencies.size(); i++)
+        context.dependencies.emplace_back(dependencies[i], hashes[i]);
+    std::ofstream stream(context.output, std::ios::binary | std::ios::trunc);
+    stream << text;
+    return (bool)stream;
+}
+
+void AssetCooker::AddDefaultRecipes()
+{
+    AddRecipe({ "texture", 1, ".png", COOKED_TEXTURE_EXTENSION, "rgba8 flipped", CookTexture });
+    AddRecipe({ "texture", 1, ".jpg", COOKED_TEXTURE_EXTENSION, "rgba8 flipped", CookTexture });
+    AddRecipe({ "shader", 1, ".shader", ".shader", "includes resolved", CookShader });
+}
+
+const CookRecipe* AssetCooker::FindRecipe(const std::string& input) const
+{
+    std::string extension = std::filesystem::path(input).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+    for (const CookRecipe& recipe : m_Recipes)
+    {
+        if (recipe.inputExtension == extension)
+            return &recipe;
+    }
+    return nullptr;
+}
+
+std::string AssetCooker::GetOutputPath(const std::string& input, const CookRecipe& recipe) const
+{
+    std::filesystem::path output = std::filesystem::path(m_OutputDirectory) / std::filesystem::path(input).relative_path();
+    output.replace_extension(recipe.outputExtension);
+    return output.generic_string();
+}
+
+unsigned long long AssetCooker::GetRecipeKey(const CookRecipe& recipe, const std::string& input)
+{
+    unsigned long long key = HashString(recipe.name);
+    key = HashBytes(&recipe.version, sizeof(recipe.version), key);
+    key = HashString(recipe.settings, key);
+    return HashString(input, key);
+}
+
+/* Content hash of [path], rehashed only when its size or modification time changed */
+bool AssetCooker::HashFile(const std::string& path, unsigned long long& hash)
+{
+    std::error_code error;
+    unsigned long long size = (unsigned long long)std::filesystem::file_size(path, error);
+    if (error)
+        return false;
+    long long time = (long long)std::filesystem::last_write_time(path, error).time_since_epoch().count();
+    if (error)
+        return false;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto it = m_Stamps.find(path);
+        if (it != m_Stamps.end() && it->second.size == size && it->second.time == time)
+        {
+            hash = it->second.hash;
+            return true;
+        }
+    }
+
+    FileData data = AsyncFileReader::ReadNow(path);
+    if (!data.IsValid())
+        return false;
+    hash = HashBytes(data.GetData(), data.GetSize());
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Stamps[path] = { size, time, hash };
+    return true;
+}
+
+bool AssetCooker::IsUpToDate(const std::string& output, unsigned long long key)
+{
+    Record record;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto it = m_Records.find(output);
+        if (it == m_Records.end() || it->second.key != key)
+            return false;
+        record = it->second;
+    }
+    std::error_code error;
+    if (!std::filesystem::exists(output, error))
+        return false;
+    for (const auto& [path, recorded] : record.dependencies)
+    {
+        unsigned long long hash;
+        if (!HashFile(path, hash) || hash != recorded)
+            return false;
+    }
+    return true;
+}
+
+bool AssetCooker::CookOne(const std::string& input, const CookRecipe& recipe, const std::string& output, unsigned long long key)
+{
+    /* hashed before the recipe reads it: a source saved while cooking then
+       differs from its record and gets cooked again on the next run */
+    unsigned long long inputHash;
+    if (!HashFile(input, inputHash))
+    {
+        std::cout << "Warning: can't read ' " << input << " ' " << std::endl;
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(output).parent_path(), error);
+
+    CookContext context = { input, output + COOK_TEMPORARY_EXTENSION, recipe.settings, {} };
+    if (!recipe.cook(context))
+    {
+        std::filesystem::remove(context.output, error);
+        std::cout << "Warning: cooking ' " << input << " ' with ' " << recipe.name << " ' failed " << std::endl;
+        return false;
+    }
+    /* a half-written output never replaces a good one */
+    std::filesystem::rename(context.output, output, error);
+    if (error)
+    {
+        std::cout << "Warning: can't write ' " << output << " ' " << std::endl;
+        return false;
+    }
+
+    /* the hashes the recipe reported come from the content it read, they win
+       over the one taken up front when the recipe reported the input too */
+    Record record = { key, std::move(context.dependencies) };
+    record.dependencies.emplace_back(input, inputHash);
+    std::stable_sort(record.dependencies.begin(), record.dependencies.end(),
+        [](const auto& a, const auto& b) { return a.first < b.first; });
+    record.dependencies.erase(std::unique(record.dependencies.begin(), record.dependencies.end(),
+        [](const auto& a, const auto& b) { return a.first == b.first; }), record.dependencies.end());
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Records[output] = std::move(record);
+    return true;
+}
+
+CookStats AssetCooker::Cook(const std::vector<std::string>& inputs, JobSystem* jobs /*= nullptr*/)
+{
+    auto start = std::chrono::steady_clock::now();
+    CookStats stats = {};
+
+    struct Item
+    {
+        const std::string* input;
+        const CookRecipe* recipe;
+        std::string output;
+        unsigned long long key;
+        int result;	// 0 up to date, 1 cooked, -1 failed
+    };
+    std::vector<Item> items;
+    std::unordered_set<std::string> outputs;
+    for (const std::string& input : inputs)
+    {
+        const CookRecipe* recipe = FindRecipe(input);
+        if (!recipe)
+        {
+            stats.skipped++;
+            continue;
+        }
+        std::string output = GetOutputPath(input, *recipe);
+        /* a.png and a.jpg would both cook to a.ctex */
+        if (!outputs.insert(output).second)
+        {
+            std::cout << "Warning: ' " << input << " ' cooks to ' " << output << " ' as well, skipped " << std::endl;
+            stats.failed++;
+            continue;
+        }
+        items.push_back({ &input, recipe, output, GetRecipeKey(*recipe, input), 0 });
+    }
+
+    /* checking reads files as well, so it runs in the same jobs as the cooking */
+    auto process = [&](unsigned int begin, unsigned int end)
+    {
+        for (unsigned int i = begin; i < end; i++)
+        {
+            Item& item = items[i];
+            if (!IsUpToDate(item.output, item.key))
+                item.result = CookOne(*item.input, *item.recipe, item.output, item.key) ? 1 : -1;
+        }
+    };
+    if (jobs)
+        jobs->ParallelFor((unsigned int)items.size(), 1, process);
+    else
+        process(0, (unsigned int)items.size());
+
+    for (const Item& item : items)
+    {
+        if (item.result > 0)
+            stats.cooked++;
+        else if (item.result < 0)
+            stats.failed++;
+        else
+            stats.upToDate++;
+    }
+    SaveDatabase();
+    stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+/* Text database, tab separated:
+       cookdb <version>
+       stamp <path> <size> <time> <hash>
+       record <output> <key> <count> (<path> <hash>) * count */
+static unsigned long long ParseNumber(const std::string& text)
+{
+    return std::strtoull(text.c_str(), nullptr, 10);
+}
+
+void AssetCooker::LoadDatabase()
+{
+    std::ifstream stream(m_DatabasePath);
+    std::string line;
+    if (!stream || !std::getline(stream, line) || line != "cookdb\t" + std::to_string(COOK_DATABASE_VERSION))
+        return;
+
+    while (std::getline(stream, line))
+    {
+        std::vector<std::string> fields;
+        std::stringstream split(line);
+        for (std::string field; std::getline(split, field, '\t');)
+            fields.push_back(field);
+
+        if (fields.size() == 5 && fields[0] == "stamp")
+            m_Stamps[fields[1]] = { ParseNumber(fields[2]), std::strtoll(fields[3].c_str(), nullptr, 10), ParseNumber(fields[4]) };
+        else if (fields.size() >= 4 && fields[0] == "record")
+        {
+            size_t count = (size_t)ParseNumber(fields[3]);
+            if (fields.size() != 4 + count * 2)
+                continue;
+            Record record = { ParseNumber(fields[2]), {} };
+            for (size_t i = 0; i < count; i++)
+                record.dependencies.emplace_back(fields[4 + i * 2], ParseNumber(fields[5 + i * 2]));
+            m_Records[fields[1]] = std::move(record);
+        }
+    }
+}
+
+void AssetCooker::SaveDatabase()
+{
+    std::error_code error;
+    std::filesystem::create_directories(m_OutputDirectory, error);
+    std::string temporary = m_DatabasePath + COOK_TEMPORARY_EXTENSION;
+    {
+        std::ofstream stream(temporary, std::ios::trunc);
+        if (!stream)
+        {
+            std::cout << "Warning: can't write cook database ' " << m_DatabasePath << " ' " << std::endl;
+            return;
+        }
+        stream << "cookdb\t" << COOK_DATABASE_VERSION << "\n";
+        for (const auto& [path, stamp] : m_Stamps)
+            stream << "stamp\t" << path << "\t" << stamp.size << "\t" << stamp.time << "\t" << stamp.hash << "\n";
+        for (const auto& [output, record] : m_Records)
+        {
+            stream << "record\t" << output << "\t" << record.key << "\t" << record.dependencies.size();
+            for (const auto& [path, hash] : record.dependencies)
+                stream << "\t" << path << "\t" << hash;
+            stream << "\n";
+        }
+    }
+    std::filesystem::rename(temporary, m_DatabasePath, error);
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class JobSystem;
+
+#define COOKED_TEXTURE_MAGIC 0x58455443  // "CTEX"
+#define COOKED_TEXTURE_EXTENSION ".ctex"
+/* Dependency database kept in the output directory, not an asset itself */
+#define COOK_DATABASE_NAME ".cookdb"
+/* Outputs and the database are written with this suffix, then renamed */
+#define COOK_TEMPORARY_EXTENSION ".tmp"
+
+/* Header of a cooked texture, followed by width * height RGBA8 pixels
+   already flipped for GL, so loading it needs no decoding */
+struct CookedTextureHeader
+{
+	uint32_t magic;
+	uint32_t width;
+	uint32_t height;
+	uint32_t reserved;
+};
+
+/* What a recipe gets to cook one input */
+struct CookContext
+{
+	std::string input;
+	/* temporary path to write to, moved into place when the recipe succeeds */
+	std::string output;
+	std::string settings;
+	/* other files the result depends on, e.g. #included shader sources, each
+	   with the content hash of what the recipe actually read from it */
+	std::vector<std::pair<std::string, unsigned long long>> dependencies;
+};
+
+/* Turns inputs with [inputExtension] into outputs with [outputExtension].
+   Raising [version] or changing [settings] re-cooks everything it made */
+struct CookRecipe
+{
+	std::string name;
+	unsigned int version;
+	std::string inputExtension;
+	std::string outputExtension;
+	std::string settings;
+	std::function<bool(CookContext&)> cook;
+};
+
+struct CookStats
+{
+	unsigned int cooked;
+	unsigned int upToDate;
+	unsigned int failed;
+	unsigned int skipped;	// no recipe for the extension
+	double milliseconds;
+};
+
+/* Incremental asset cooker. Every output remembers the recipe key (name,
+   version, settings, input path) and the content hash of each file it was
+   made from in a database next to the outputs; an output is only cooked
+   again when one of them changed. Content hashes are cached by file size
+   and modification time, so an unchanged tree is checked without reading
+   it. Out-of-date inputs are cooked in parallel on the job system. */
+class AssetCooker
+{
+private:
+	struct Record
+	{
+		unsigned long long key;
+		std::vector<std::pair<std::string, unsigned long long>> dependencies;
+	};
+	struct FileStamp
+	{
+		unsigned long long size;
+		long long time;
+		unsigned long long hash;
+	};
+
+	std::string m_OutputDirectory;
+	std::string m_DatabasePath;
+	std::vector<CookRecipe> m_Recipes;
+	std::unordered_map<std::string, Record> m_Records;		// by output path
+	std::unordered_map<std::string, FileStamp> m_Stamps;	// by file path
+	std::mutex m_Mutex;
+
+	const CookRecipe* FindRecipe(const std::string& input) const;
+	std::string GetOutputPath(const std::string& input, const CookRecipe& recipe) const;
+	bool HashFile(const std::string& path, unsigned long long& hash);
+	bool IsUpToDate(const std::string& output, unsigned long long key);
+	bool CookOne(const std::string& input, const CookRecipe& recipe, const std::string& output, unsigned long long key);
+
+	void LoadDatabase();
+	void SaveDatabase();
+public:
+	/* Outputs mirror the input paths below [outputDirectory], with the
+	   recipe's extension: res/a.png cooks to <outputDirectory>/res/a.ctex */
+	AssetCooker(const std::string& outputDirectory);
+
+	void AddRecipe(const CookRecipe& recipe);
+	/* Textures to CookedTextureHeader + pixels (.ctex), shaders with their #includes resolved */
+	void AddDefaultRecipes();
+
+	/* Brings the outputs of [inputs] up to date and saves the database */
+	CookStats Cook(const std::vector<std::string>& inputs, JobSystem* jobs = nullptr);
+
+	static unsigned long long GetRecipeKey(const CookRecipe& recipe, const std::string& input);
+};
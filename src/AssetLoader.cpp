@@ -0,0 +1,70 @@
+#include "AssetLoader.h"
+
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include "AssetCooker.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "vendor/stb_image/stb_image.h"
+
+AssetLoader::AssetLoader(JobSystem& jobs, ResourceFactory& resources, AsyncFileReader& files)
+    : m_Jobs(jobs), m_Resources(resources), m_Files(files), m_Pack(nullptr)
+{
+}
+
+void AssetLoader::Resume(std::coroutine_handle<> handle)
+{
+    m_Jobs.Run(m_Jobs.Create([handle]() { handle.resume(); }));
+}
+
+Task<std::shared_ptr<Texture>> AssetLoader::LoadTexture(std::string path)
+{
+    /* a pack of the cooked tree holds res/a.ctex in place of res/a.png */
+    std::string cookedPath = std::filesystem::path(path).replace_extension(COOKED_TEXTURE_EXTENSION).generic_string();
+    bool packed = m_Pack && m_Pack->Contains(cookedPath);
+    FileData file = co_await ReadFile(packed ? cookedPath : path);
+    if (!file.IsValid())
+        co_return nullptr;
+
+    /* cooked textures are decoded and flipped already, see AssetCooker */
+    CookedTextureHeader cooked = {};
+    if (file.GetSize() >= sizeof(cooked))
+        std::memcpy(&cooked, file.GetData(), sizeof(cooked));
+    if (cooked.magic == COOKED_TEXTURE_MAGIC && file.GetSize() == sizeof(cooked) + (size_t)cooked.width * cooked.height * 4)
+    {
+        const unsigned char* pixels = (const unsigned char*)file.GetData() + sizeof(cooked);
+        co_return co_await CreateOnGLThread<Texture>([pixels, cooked]()
+        {
+            return new Texture(pixels, (int)cooked.width, (int)cooked.height);
+        });
+    }
+
+    /* decoded on a worker, straight from the read buffer */
+    int width = 0, height = 0, channels = 0;
+    stbi_set_flip_vertically_on_load_thread(1);
+    unsigned char* pixels = stbi_load_from_memory((const stbi_uc*)file.GetData(), (int)file.GetSize(), &width, &height, &channels, 4);
+    if (!pixels)
+    {
+        std::cout << "Warning: texture ' " << path << " ' couldn't be decoded " << std::endl;
+        co_return nullptr;
+    }
+
+    std::shared_ptr<Texture> texture = co_await CreateOnGLThread<Texture>([pixels, width, height]()
+    {
+        return new Texture(pixels, width, height);
+    });
+    stbi_image_free(pixels);
+    co_return texture;
+}
+
+Task<std::shared_ptr<Shader>> AssetLoader::LoadShader(std::string filepath, ShaderDefines defines /*= {}*/)
+{
+    /* #include resolution reads files too, so parsing happens on a worker */
+    co_await Schedule();
+    ShaderProgramSource source = Shader::ParseShader(filepath, defines);
+    co_return co_await CreateOnGLThread<Shader>([filepath, source]()
+    {
+        return new Shader(filepath, source);
+    });
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <coroutine>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AssetPack.h"
+#include "AsyncFileReader.h"
+#include "JobSystem.h"
+#include "ResourceFactory.h"
+#include "ShaderPreprocessor.h"
+#include "Task.h"
+
+/* Asset loading written as coroutines:
+
+       Task<std::shared_ptr<Texture>> LoadGold(AssetLoader& assets)
+       {
+           co_return co_await assets.LoadTexture("res/textures/gold.png");
+       }
+
+   Files come from the mounted AssetPack when it has them, from the
+   AsyncFileReader otherwise, and are decoded on the job system; a texture
+   whose cooked form (AssetCooker) is in the pack skips decoding. GL
+   objects are created by the ResourceFactory on the GL thread, and the
+   coroutine continues on a worker after each step. Starting several loads before awaiting any of
+   them lets their reads and decodes overlap. */
+class AssetLoader
+{
+private:
+	JobSystem& m_Jobs;
+	ResourceFactory& m_Resources;
+	AsyncFileReader& m_Files;
+	const AssetPack* m_Pack;
+public:
+	AssetLoader(JobSystem& jobs, ResourceFactory& resources, AsyncFileReader& files);
+
+	/* Files found in [pack] are read from it from now on; nullptr unmounts */
+	inline void Mount(const AssetPack* pack) { m_Pack = pack; }
+
+	/* Continues the awaiting coroutine as a job */
+	void Resume(std::coroutine_handle<> handle);
+
+	/* co_await Schedule() moves the coroutine onto a worker */
+	struct ScheduleAwaiter
+	{
+		AssetLoader& loader;
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(std::coroutine_handle<> handle) { loader.Resume(handle); }
+		void await_resume() const noexcept {}
+	};
+	inline ScheduleAwaiter Schedule() { return ScheduleAwaiter{ *this }; }
+
+	/* co_await ReadFile(path) gives the whole file, invalid if it can't be read;
+	   decoders work on the completion buffer directly */
+	struct ReadAwaiter
+	{
+		AssetLoader& loader;
+		std::string path;
+		FileData data;
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(std::coroutine_handle<> handle)
+		{
+			if (loader.m_Pack && loader.m_Pack->Contains(path))
+			{
+				/* the chunks decompress in parallel, this job waits for them */
+				loader.m_Jobs.Run(loader.m_Jobs.Create([this, handle]()
+				{
+					data = loader.m_Pack->Read(path, &loader.m_Jobs);
+					handle.resume();
+				}));
+				return;
+			}
+			loader.m_Files.Read(path, [this, handle](FileData read)
+			{
+				data = std::move(read);
+				loader.Resume(handle);
+			});
+		}
+		FileData await_resume() { return std::move(data); }
+	};
+	inline ReadAwaiter ReadFile(const std::string& path) { return ReadAwaiter{ *this, path, {} }; }
+
+	/* co_await CreateOnGLThread<T>(create) runs [create] on the GL thread */
+	template<typename T>
+	struct CreateAwaiter
+	{
+		AssetLoader& loader;
+		std::function<T*()> create;
+		std::shared_ptr<T> resource;
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(std::coroutine_handle<> handle)
+		{
+			loader.m_Resources.CreateAsync<T>(std::move(create), [this, handle](std::shared_ptr<T> created)
+			{
+				resource = std::move(created);
+				loader.Resume(handle);
+			});
+		}
+		std::shared_ptr<T> await_resume() { return std::move(resource); }
+	};
+	template<typename T>
+	CreateAwaiter<T> CreateOnGLThread(std::function<T*()> create) { return CreateAwaiter<T>{ *this, std::move(create), nullptr }; }
+
+	/* Null when the file is missing or can't be decoded */
+	Task<std::shared_ptr<Texture>> LoadTexture(std::string path);
+	Task<std::shared_ptr<Shader>> LoadShader(std::string filepath, ShaderDefines defines = {});
+
+	/* Blocks until [task] finished, running jobs meanwhile; the thread that owns
+	   the GL context passes [processResources] so the GL requests get served */
+	template<typename T>
+	T Wait(Task<T>& task, bool processResources = false)
+	{
+		while (!task.IsReady())
+		{
+			bool progress = processResources && m_Resources.Process(1.0) > 0;
+			if (!m_Jobs.ExecuteOne() && !progress)
+				std::this_thread::yield();
+		}
+		return task.GetResult();
+	}
+};
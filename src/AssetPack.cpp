@@ -0,0 +1,301 @@
+#include "AssetPack.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include "Hash.h"
+#include "JobSystem.h"
+#include "Lz4.h"
+
+/* Chunks decompressed per job; a 64 KB chunk alone is too little work to schedule */
+#define ASSET_PACK_JOB_GRAIN 4
+
+AssetPack::AssetPack()
+    : m_Data(nullptr), m_Size(0), m_Header(nullptr), m_Chunks(nullptr), m_Entries(nullptr), m_Names(nullptr)
+{
+}
+
+AssetPack::~AssetPack()
+{
+    Close();
+}
+
+bool AssetPack::Open(const std::string& path)
+{
+    Close();
+    if (!m_File.Open(path))
+        return false;
+
+    m_Data = m_File.GetData();
+    m_Size = m_File.GetSize();
+    if (!Validate())
+    {
+        std::cout << "Warning: ' " << path << " ' is not a valid asset pack " << std::endl;
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void AssetPack::Close()
+{
+    m_File.Close();
+    m_Data = nullptr;
+    m_Size = 0;
+    m_Header = nullptr;
+    m_Chunks = nullptr;
+    m_Entries = nullptr;
+    m_Names = nullptr;
+}
+
+/* Checks every table once so lookups and reads can trust them */
+bool AssetPack::Validate()
+{
+    if (m_Size < sizeof(AssetPackHeader))
+        return false;
+    const AssetPackHeader* header = (const AssetPackHeader*)m_Data;
+    if (header->magic != ASSET_PACK_MAGIC || header->version != ASSET_PACK_VERSION || header->chunkSize == 0)
+        return false;
+
+    auto fits = [this](uint64_t offset, uint64_t size) { return offset <= m_Size && size <= m_Size - offset; };
+    if (header->chunkTableOffset % 8 != 0 || header->entryTableOffset % 8 != 0 ||
+        !fits(header->chunkTableOffset, (uint64_t)header->chunkCount * sizeof(AssetPackChunk)) ||
+        !fits(header->entryTableOffset, (uint64_t)header->entryCount * sizeof(AssetPackEntry)) ||
+        !fits(header->namesOffset, header->namesSize))
+        return false;
+
+    const AssetPackChunk* chunks = (const AssetPackChunk*)(m_Data + header->chunkTableOffset);
+    for (uint32_t i = 0; i < header->chunkCount; i++)
+    {
+        if (chunks[i].size > header->chunkSize || !fits(chunks[i].offset, chunks[i].compressedSize))
+            return false;
+    }
+    const AssetPackEntry* entries = (const AssetPackEntry*)(m_Data + header->entryTableOffset);
+    for (uint32_t i = 0; i < header->entryCount; i++)
+    {
+        const AssetPackEntry& entry = entries[i];
+        if ((uint64_t)entry.firstChunk + entry.chunkCount > header->chunkCount ||
+            (uint64_t)entry.nameOffset + entry.nameLength > header->namesSize ||
+            entry.chunkCount != (entry.size + header->chunkSize - 1) / header->chunkSize)
+            return false;
+        if (i > 0 && entries[i - 1].nameHash > entry.nameHash)
+            return false;
+    }
+
+    m_Header = header;
+    m_Chunks = chunks;
+    m_Entries = entries;
+    m_Names = m_Data + header->namesOffset;
+    return true;
+}
+
+const AssetPackEntry* AssetPack::Find(const std::string& name) const
+{
+    if (!m_Header)
+        return nullptr;
+    uint64_t hash = HashString(name);
+    const AssetPackEntry* end = m_Entries + m_Header->entryCount;
+    const AssetPackEntry* entry = std::lower_bound(m_Entries, end, hash,
+        [](const AssetPackEntry& candidate, uint64_t key) { return candidate.nameHash < key; });
+    /* names sharing a hash sit next to each other */
+    for (; entry != end && entry->nameHash == hash; entry++)
+    {
+        if (entry->nameLength == name.size() && std::memcmp(m_Names + entry->nameOffset, name.data(), name.size()) == 0)
+            return entry;
+    }
+    return nullptr;
+}
+
+bool AssetPack::Contains(const std::string& name) const
+{
+    return Find(NormalizeName(name)) != nullptr;
+}
+
+FileData AssetPack::Read(const std::string& name, JobSystem* jobs /*= nullptr*/) const
+{
+    const AssetPackEntry* entry = Find(NormalizeName(name));
+    if (!entry)
+        return FileData();
+
+    FileData data((size_t)entry->size);
+    const size_t chunkSize = m_Header->chunkSize;
+    std::atomic<bool> corrupt(false);
+    auto decompress = [&](unsigned int begin, unsigned int end)
+    {
+        for (unsigned int i = begin; i < end; i++)
+        {
+            const AssetPackChunk& chunk = m_Chunks[entry->firstChunk + i];
+            size_t offset = (size_t)i * chunkSize;
+            size_t expected = std::min<size_t>(chunkSize, (size_t)entry->size - offset);
+            const char* source = m_Data + chunk.offset;
+            if (chunk.size != expected)
+                corrupt = true;
+            else if (chunk.compressedSize == chunk.size)
+                std::memcpy(data.GetData() + offset, source, chunk.size);
+            else if (!Lz4::Decompress(source, chunk.compressedSize, data.GetData() + offset, chunk.size))
+                corrupt = true;
+        }
+    };
+    if (jobs)
+        jobs->ParallelFor(entry->chunkCount, ASSET_PACK_JOB_GRAIN, decompress);
+    else
+        decompress(0, entry->chunkCount);
+
+    if (corrupt)
+    {
+        std::cout << "Warning: ' " << name << " ' is corrupt in the asset pack " << std::endl;
+        return FileData();
+    }
+    data.SetSize((size_t)entry->size);
+    return data;
+}
+
+std::string AssetPack::NormalizeName(const std::string& name)
+{
+    std::string normalized = name;
+    std::replace(normalized.begin(), normalized.end(), '\\', '/');
+    while (normalized.compare(0, 2, "./") == 0)
+        normalized.erase(0, 2);
+    return normalized;
+}
+
+bool AssetPack::Build(const std::vector<std::string>& names, const std::string& output, JobSystem* jobs /*= nullptr*/,
+    const std::string& root /*= ""*/)
+{
+    struct Source
+    {
+        std::string name;
+        FileData data;
+        uint32_t firstChunk;
+        uint32_t chunkCount;
+    };
+    std::vector<Source> sources;
+    std::vector<std::pair<uint32_t, uint32_t>> chunkSources;  // (source, chunk within it)
+    for (const std::string& name : names)
+    {
+        std::string packName = NormalizeName(name);
+        if (!root.empty())
+        {
+            packName = std::filesystem::path(packName).lexically_relative(NormalizeName(root)).generic_string();
+            if (packName.empty() || packName.compare(0, 2, "..") == 0)
+            {
+                std::cout << "Warning: ' " << name << " ' is not below ' " << root << " ' " << std::endl;
+                return false;
+            }
+        }
+        Source source = { packName, AsyncFileReader::ReadNow(name), (uint32_t)chunkSources.size(), 0 };
+        if (!source.data.IsValid())
+            return false;
+        source.chunkCount = (uint32_t)((source.data.GetSize() + ASSET_PACK_CHUNK_SIZE - 1) / ASSET_PACK_CHUNK_SIZE);
+        for (uint32_t i = 0; i < source.chunkCount; i++)
+            chunkSources.emplace_back((uint32_t)sources.size(), i);
+        sources.push_back(std::move(source));
+    }
+
+    /* chunks that don't shrink are stored as they are */
+    std::vector<std::vector<char>> compressed(chunkSources.size());
+    auto compress = [&](unsigned int begin, unsigned int end)
+    {
+        for (unsigned int i = begin; i < end; i++)
+        {
+            const Source& source = sources[chunkSources[i].first];
+            size_t offset = (size_t)chunkSources[i].second * ASSET_PACK_CHUNK_SIZE;
+            size_t size = std::min<size_t>(ASSET_PACK_CHUNK_SIZE, source.data.GetSize() - offset);
+            const char* data = source.data.GetData() + offset;
+            compressed[i].resize(Lz4::CompressBound(size));
+            size_t length = Lz4::Compress(data, size, compressed[i].data(), compressed[i].size());
+            if (length == 0 || length >= size)
+                compressed[i].assign(data, data + size);
+            else
+                compressed[i].resize(length);
+        }
+    };
+    if (jobs)
+        jobs->ParallelFor((unsigned int)chunkSources.size(), 1, compress);
+    else
+        compress(0, (unsigned int)chunkSources.size());
+
+    /* everything that can fail is checked before [output] is touched */
+    std::vector<AssetPackEntry> entries;
+    std::string namesBlock;
+    for (const Source& source : sources)
+    {
+        entries.push_back({ HashString(source.name), source.data.GetSize(), source.firstChunk, source.chunkCount,
+            (uint32_t)namesBlock.size(), (uint32_t)source.name.size() });
+        namesBlock += source.name;
+    }
+    std::sort(entries.begin(), entries.end(), [](const AssetPackEntry& a, const AssetPackEntry& b) { return a.nameHash < b.nameHash; });
+    for (size_t i = 1; i < entries.size(); i++)
+    {
+        const AssetPackEntry& a = entries[i - 1];
+        const AssetPackEntry& b = entries[i];
+        if (a.nameHash == b.nameHash && a.nameLength == b.nameLength &&
+            namesBlock.compare(a.nameOffset, a.nameLength, namesBlock, b.nameOffset, b.nameLength) == 0)
+        {
+            std::cout << "Warning: ' " << namesBlock.substr(a.nameOffset, a.nameLength) << " ' is packed twice " << std::endl;
+            return false;
+        }
+    }
+
+    std::vector<AssetPackChunk> chunks(chunkSources.size());
+    uint64_t offset = sizeof(AssetPackHeader);
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        const Source& source = sources[chunkSources[i].first];
+        size_t begin = (size_t)chunkSources[i].second * ASSET_PACK_CHUNK_SIZE;
+        chunks[i] = { offset, (uint32_t)compressed[i].size(), (uint32_t)std::min<size_t>(ASSET_PACK_CHUNK_SIZE, source.data.GetSize() - begin) };
+        offset += compressed[i].size();
+    }
+    /* the tables are read in place, keep them aligned */
+    uint64_t padding = (8 - offset % 8) % 8;
+
+    AssetPackHeader header = {};
+    header.magic = ASSET_PACK_MAGIC;
+    header.version = ASSET_PACK_VERSION;
+    header.chunkSize = ASSET_PACK_CHUNK_SIZE;
+    header.entryCount = (uint32_t)entries.size();
+    header.chunkCount = (uint32_t)chunks.size();
+    header.namesSize = (uint32_t)namesBlock.size();
+    header.chunkTableOffset = offset + padding;
+    header.entryTableOffset = header.chunkTableOffset + chunks.size() * sizeof(AssetPackChunk);
+    header.namesOffset = header.entryTableOffset + entries.size() * sizeof(AssetPackEntry);
+
+    /* written next to [output] and moved over it, so a failed build never
+       replaces a good pack */
+    std::string temporary = output + ".tmp";
+    std::error_code error;
+    {
+        std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+        if (!stream)
+        {
+            std::cout << "Warning: can't write asset pack ' " << output << " ' " << std::endl;
+            return false;
+        }
+        const char zeros[8] = {};
+        stream.write((const char*)&header, sizeof(header));
+        for (const std::vector<char>& chunk : compressed)
+            stream.write(chunk.data(), (std::streamsize)chunk.size());
+        stream.write(zeros, (std::streamsize)padding);
+        stream.write((const char*)chunks.data(), (std::streamsize)(chunks.size() * sizeof(AssetPackChunk)));
+        stream.write((const char*)entries.data(), (std::streamsize)(entries.size() * sizeof(AssetPackEntry)));
+        stream.write(namesBlock.data(), (std::streamsize)namesBlock.size());
+        if (!stream.flush())
+        {
+            std::cout << "Warning: can't write asset pack ' " << output << " ' " << std::endl;
+            stream.close();
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+    }
+    std::filesystem::rename(temporary, output, error);
+    if (error)
+    {
+        std::cout << "Warning: can't write asset pack ' " << output << " ' " << std::endl;
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "AsyncFileReader.h"
+#include "MappedFile.h"
+
+class JobSystem;
+
+#define ASSET_PACK_MAGIC 0x4B415041  // "APAK"
+#define ASSET_PACK_VERSION 1
+#define ASSET_PACK_CHUNK_SIZE (64u << 10)
+
+/* Pack layout: header, compressed chunks, chunk table, entry table sorted
+   by name hash, then the names. Little-endian, as written by Build() */
+struct AssetPackHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t chunkSize;
+	uint32_t entryCount;
+	uint32_t chunkCount;
+	uint32_t namesSize;
+	uint64_t chunkTableOffset;
+	uint64_t entryTableOffset;
+	uint64_t namesOffset;
+};
+
+/* A chunk whose compressed size equals its size is stored as is */
+struct AssetPackChunk
+{
+	uint64_t offset;
+	uint32_t compressedSize;
+	uint32_t size;
+};
+
+struct AssetPackEntry
+{
+	uint64_t nameHash;
+	uint64_t size;
+	uint32_t firstChunk;
+	uint32_t chunkCount;
+	uint32_t nameOffset;
+	uint32_t nameLength;
+};
+
+/* Read-only archive of asset files, memory-mapped as a whole.
+   Files are found through a hashed table of contents and stored as
+   ASSET_PACK_CHUNK_SIZE chunks compressed with LZ4 independently of each
+   other, so one file's chunks decompress in parallel. Names are the paths
+   the files had when the pack was built, such as "res/textures/gold.png",
+   relative to the root given to Build(). */
+class AssetPack
+{
+private:
+	MappedFile m_File;
+	const char* m_Data;
+	size_t m_Size;
+	const AssetPackHeader* m_Header;
+	const AssetPackChunk* m_Chunks;
+	const AssetPackEntry* m_Entries;
+	const char* m_Names;
+
+	bool Validate();
+	const AssetPackEntry* Find(const std::string& name) const;
+public:
+	AssetPack();
+	~AssetPack();
+
+	AssetPack(const AssetPack&) = delete;
+	AssetPack& operator=(const AssetPack&) = delete;
+
+	/* False if the file can't be mapped or isn't a valid pack */
+	bool Open(const std::string& path);
+	void Close();
+
+	bool Contains(const std::string& name) const;
+	/* Decompresses a whole file, its chunks spread over [jobs] when given;
+	   invalid if the file isn't in the pack or a chunk is corrupt */
+	FileData Read(const std::string& name, JobSystem* jobs = nullptr) const;
+
+	inline bool IsOpen() const { return m_Header != nullptr; }
+	inline unsigned int GetFileCount() const { return m_Header ? m_Header->entryCount : 0; }
+
+	/* Writes the files [names] into a pack at [output], compressing on [jobs] when given.
+	   With a [root] the files are named relative to it, so "cooked/res/a.ctex"
+	   packed with root "cooked" is found as "res/a.ctex" */
+	static bool Build(const std::vector<std::string>& names, const std::string& output, JobSystem* jobs = nullptr,
+		const std::string& root = "");
+	/* Separators as written by the pack builder, so "res\\a.png" finds "res/a.png" */
+	static std::string NormalizeName(const std::string& name);
+};
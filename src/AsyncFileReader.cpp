@@ -0,0 +1,326 @@
+#include "AsyncFileReader.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <new>
+
+#ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__has_include)
+#if __has_include(<liburing.h>)
+#include <liburing.h>
+#define FILE_IO_URING
+#endif
+#endif
+#endif
+
+/* Buffer alignment, a multiple of the logical block size O_DIRECT asks for */
+#define FILE_IO_ALIGNMENT 4096
+/* Files from this size on bypass the page cache */
+#define FILE_IO_DIRECT_THRESHOLD (16u << 20)
+
+static size_t AlignUp(size_t size)
+{
+    return (size + FILE_IO_ALIGNMENT - 1) / FILE_IO_ALIGNMENT * FILE_IO_ALIGNMENT;
+}
+
+void FileData::AlignedDelete::operator()(char* buffer) const
+{
+    ::operator delete[](buffer, std::align_val_t(FILE_IO_ALIGNMENT));
+}
+
+FileData::FileData(size_t capacity)
+    : m_Size(0), m_Capacity(std::max<size_t>(AlignUp(capacity), FILE_IO_ALIGNMENT))
+{
+    m_Buffer.reset(static_cast<char*>(::operator new[](m_Capacity, std::align_val_t(FILE_IO_ALIGNMENT))));
+}
+
+#ifdef FILE_IO_URING
+struct AsyncFileReader::Ring
+{
+    io_uring ring;
+};
+#else
+struct AsyncFileReader::Ring
+{
+};
+#endif
+
+AsyncFileReader::AsyncFileReader(unsigned int threadCount /*= 2*/, unsigned int queueDepth /*= 64*/)
+    : m_QueueDepth(std::max(1u, queueDepth)), m_Stop(false)
+{
+#ifdef FILE_IO_URING
+    /* kernels before 5.1, or sandboxes that filter io_uring, refuse the ring */
+    std::unique_ptr<Ring> ring(new Ring());
+    if (io_uring_queue_init(m_QueueDepth, &ring->ring, 0) == 0)
+    {
+        m_Ring = std::move(ring);
+        m_Threads.emplace_back(&AsyncFileReader::RingLoop, this);
+        return;
+    }
+#endif
+    for (unsigned int i = 0; i < std::max(1u, threadCount); i++)
+        m_Threads.emplace_back(&AsyncFileReader::PoolLoop, this);
+}
+
+AsyncFileReader::~AsyncFileReader()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_WakeUp.notify_all();
+    for (std::thread& thread : m_Threads)
+        thread.join();
+#ifdef FILE_IO_URING
+    if (m_Ring)
+        io_uring_queue_exit(&m_Ring->ring);
+#endif
+}
+
+void AsyncFileReader::Read(const std::string& path, FileReadCallback done)
+{
+    std::unique_ptr<Request> request(new Request());
+    request->path = path;
+    request->done = std::move(done);
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Queue.push_back(std::move(request));
+    }
+    m_WakeUp.notify_one();
+}
+
+void AsyncFileReader::Read(const std::vector<std::string>& paths, const std::function<void(size_t, FileData)>& done)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (size_t i = 0; i < paths.size(); i++)
+        {
+            std::unique_ptr<Request> request(new Request());
+            request->path = paths[i];
+            request->done = [done, i](FileData data) { done(i, std::move(data)); };
+            m_Queue.push_back(std::move(request));
+        }
+    }
+    m_WakeUp.notify_all();
+}
+
+FileData AsyncFileReader::ReadNow(const std::string& path)
+{
+    FileData data;
+    Request request;
+    request.path = path;
+    request.done = [&data](FileData read) { data = std::move(read); };
+    ReadBlocking(request);
+    Complete(&request);
+    return data;
+}
+
+void AsyncFileReader::Complete(Request* request)
+{
+#ifdef __linux__
+    if (request->file >= 0)
+        close(request->file);
+#endif
+    if (request->data.IsValid())
+        request->data.SetSize(std::min(request->offset, request->size));
+    else
+        std::cout << "Warning: file ' " << request->path << " ' couldn't be read " << std::endl;
+    if (request->done)
+        request->done(std::move(request->data));
+}
+
+void AsyncFileReader::PoolLoop()
+{
+    while (true)
+    {
+        std::unique_ptr<Request> request;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_WakeUp.wait(lock, [this]() { return !m_Queue.empty() || m_Stop; });
+            if (m_Queue.empty())
+                return;
+            request = std::move(m_Queue.front());
+            m_Queue.pop_front();
+        }
+        ReadBlocking(*request);
+        Complete(request.get());
+    }
+}
+
+#ifdef __linux__
+/* Opens the file and sizes its buffer; direct I/O reads whole blocks, so the
+   buffer is rounded up and the read may return less than it asked for */
+bool AsyncFileReader::Open(Request& request)
+{
+    request.file = open(request.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (request.file < 0)
+        return false;
+    struct stat status;
+    if (fstat(request.file, &status) != 0)
+    {
+        close(request.file);
+        request.file = -1;
+        return false;
+    }
+    request.size = (size_t)status.st_size;
+    if (request.size >= FILE_IO_DIRECT_THRESHOLD)
+    {
+        /* tmpfs and some network file systems don't do O_DIRECT */
+        int direct = open(request.path.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT);
+        if (direct >= 0)
+        {
+            close(request.file);
+            request.file = direct;
+            request.direct = true;
+        }
+    }
+    request.data = FileData(request.size);
+    return true;
+}
+
+/* Direct reads need aligned offsets, after an odd short read the rest goes through the cache */
+bool AsyncFileReader::ReopenBuffered(Request& request)
+{
+    int file = open(request.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0)
+        return false;
+    close(request.file);
+    request.file = file;
+    request.direct = false;
+    return true;
+}
+
+void AsyncFileReader::ReadBlocking(Request& request)
+{
+    if (!Open(request))
+        return;
+    while (request.offset < request.size)
+    {
+        size_t length = request.direct ? request.data.GetCapacity() - request.offset : request.size - request.offset;
+        ssize_t count = pread(request.file, request.data.GetData() + request.offset, length, (off_t)request.offset);
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count < 0 && errno == EINVAL && request.direct && ReopenBuffered(request))
+            continue;
+        if (count < 0)
+        {
+            request.data = FileData();
+            return;
+        }
+        if (count == 0)
+            break;  // truncated while reading
+        request.offset += (size_t)count;
+        if (request.direct && request.offset % FILE_IO_ALIGNMENT != 0 && request.offset < request.size)
+            ReopenBuffered(request);
+    }
+}
+#else
+/* Open() and ReopenBuffered() are only used by the POSIX reads above and the ring */
+void AsyncFileReader::ReadBlocking(Request& request)
+{
+    std::ifstream stream(request.path, std::ios::binary | std::ios::ate);
+    if (!stream)
+        return;
+    request.size = (size_t)stream.tellg();
+    request.data = FileData(request.size);
+    stream.seekg(0);
+    stream.read(request.data.GetData(), (std::streamsize)request.size);
+    request.offset = (size_t)stream.gcount();
+}
+#endif
+
+#ifdef FILE_IO_URING
+void AsyncFileReader::QueueRead(Request* request)
+{
+    size_t length = request->direct ? request->data.GetCapacity() - request->offset : request->size - request->offset;
+    /* at most m_QueueDepth reads are in flight, so the submission queue has room */
+    io_uring_sqe* sqe = io_uring_get_sqe(&m_Ring->ring);
+    io_uring_prep_read(sqe, request->file, request->data.GetData() + request->offset, (unsigned int)std::min<size_t>(length, 1u << 30),
+        (uint64_t)request->offset);
+    io_uring_sqe_set_data(sqe, request);
+}
+
+void AsyncFileReader::RingLoop()
+{
+    unsigned int inFlight = 0;
+    while (true)
+    {
+        std::vector<std::unique_ptr<Request>> batch;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            if (inFlight == 0)
+                m_WakeUp.wait(lock, [this]() { return !m_Queue.empty() || m_Stop; });
+            if (m_Queue.empty() && inFlight == 0)
+                return;
+            while (!m_Queue.empty() && inFlight + batch.size() < m_QueueDepth)
+            {
+                batch.push_back(std::move(m_Queue.front()));
+                m_Queue.pop_front();
+            }
+        }
+
+        for (std::unique_ptr<Request>& request : batch)
+        {
+            if (!Open(*request) || request->size == 0)
+            {
+                Complete(request.get());
+                continue;
+            }
+            QueueRead(request.release());
+            inFlight++;
+        }
+        /* one submission for the new reads and the resubmitted short ones */
+        io_uring_submit(&m_Ring->ring);
+        if (inFlight == 0)
+            continue;
+
+        /* reads queued meanwhile wait for this completion, which is never far off */
+        io_uring_cqe* cqe = nullptr;
+        int result = io_uring_wait_cqe(&m_Ring->ring, &cqe);
+        if (result < 0)
+            continue;
+
+        unsigned int head;
+        unsigned int reaped = 0;
+        io_uring_for_each_cqe(&m_Ring->ring, head, cqe)
+        {
+            reaped++;
+            Request* request = static_cast<Request*>(io_uring_cqe_get_data(cqe));
+            int count = cqe->res;
+            bool resubmit = false;
+            bool failed = false;
+            if (count == -EINTR || count == -EAGAIN)
+                resubmit = true;
+            else if (count == -EINVAL && request->direct)
+                failed = !(resubmit = ReopenBuffered(*request));
+            else if (count > 0)
+            {
+                request->offset += (size_t)count;
+                resubmit = request->offset < request->size;
+                if (resubmit && request->direct && request->offset % FILE_IO_ALIGNMENT != 0)
+                    failed = !(resubmit = ReopenBuffered(*request));
+            }
+            else if (count < 0)
+                failed = true;
+
+            if (failed)
+                request->data = FileData();
+
+            if (resubmit)
+                QueueRead(request);
+            else
+            {
+                inFlight--;
+                Complete(request);
+                delete request;
+            }
+        }
+        io_uring_cq_advance(&m_Ring->ring, reaped);
+    }
+}
+#endif
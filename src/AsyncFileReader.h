@@ -0,0 +1,99 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* Contents of a file read by the AsyncFileReader. The buffer is aligned for
+   direct I/O and may be larger than the file, GetSize() is the file size */
+class FileData
+{
+private:
+	struct AlignedDelete { void operator()(char* buffer) const; };
+
+	std::unique_ptr<char[], AlignedDelete> m_Buffer;
+	size_t m_Size;
+	size_t m_Capacity;
+public:
+	FileData()
+		: m_Size(0), m_Capacity(0) {}
+	explicit FileData(size_t capacity);
+
+	inline char* GetData() { return m_Buffer.get(); }
+	inline const char* GetData() const { return m_Buffer.get(); }
+	inline size_t GetSize() const { return m_Size; }
+	inline size_t GetCapacity() const { return m_Capacity; }
+	inline void SetSize(size_t size) { m_Size = size; }
+	/* False when the file couldn't be opened or read */
+	inline bool IsValid() const { return m_Buffer != nullptr; }
+};
+
+/* Called on an I/O thread once the whole file is in memory; keep it short
+   and hand decoding to a job */
+typedef std::function<void(FileData)> FileReadCallback;
+
+/* Reads whole files asynchronously.
+   On Linux with liburing (link with -luring) a single thread drives an
+   io_uring: every read queued since its last pass goes out with one
+   submission, so hundreds of asset reads cost a handful of system calls.
+   Elsewhere, or when the kernel refuses a ring, a few threads read with
+   blocking calls instead. Files of FILE_IO_DIRECT_THRESHOLD bytes and more
+   are opened with O_DIRECT where supported, so big packs read once don't
+   evict the rest of the page cache. */
+class AsyncFileReader
+{
+private:
+	struct Request
+	{
+		std::string path;
+		FileReadCallback done;
+		FileData data;
+		size_t size = 0;
+		size_t offset = 0;
+		int file = -1;
+		bool direct = false;
+	};
+	struct Ring;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_WakeUp;
+	std::deque<std::unique_ptr<Request>> m_Queue;
+	std::vector<std::thread> m_Threads;
+	std::unique_ptr<Ring> m_Ring;
+	unsigned int m_QueueDepth;
+	bool m_Stop;
+
+	void PoolLoop();
+	// io_uring backend, only defined where liburing is available
+	void RingLoop();
+	void QueueRead(Request* request);
+
+	static void Complete(Request* request);
+	// POSIX only
+	static bool Open(Request& request);
+	static bool ReopenBuffered(Request& request);
+	static void ReadBlocking(Request& request);
+public:
+	/* [threadCount] is only used by the fallback, [queueDepth] caps the reads in flight */
+	AsyncFileReader(unsigned int threadCount = 2, unsigned int queueDepth = 64);
+	/* Finishes the queued reads */
+	~AsyncFileReader();
+
+	AsyncFileReader(const AsyncFileReader&) = delete;
+	AsyncFileReader& operator=(const AsyncFileReader&) = delete;
+
+	void Read(const std::string& path, FileReadCallback done);
+	/* Queues all [paths] at once so they share a submission; [done] gets the index into [paths] */
+	void Read(const std::vector<std::string>& paths, const std::function<void(size_t, FileData)>& done);
+
+	/* Reads [path] on the calling thread */
+	static FileData ReadNow(const std::string& path);
+
+	inline bool IsUsingIoUring() const { return m_Ring != nullptr; }
+};
@@ -0,0 +1,322 @@
+#include "BVH.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include "Frustum.h"
+
+/* Centroid bins evaluated per axis by the SAH split search */
+#define BVH_BINS 16
+/* Leaves stop splitting at this many objects */
+#define BVH_MAX_LEAF_SIZE 2
+/* Deepest traversal stack the queries need, far above a balanced tree of millions */
+#define BVH_STACK_SIZE 64
+/* Nodes this deep become leaves however many objects they hold, so skewed
+   input can't grow the tree past the traversal stack; a depth-first walk
+   never holds more than one entry per level plus one */
+#define BVH_MAX_DEPTH 48
+
+static_assert(BVH_MAX_DEPTH + 1 <= BVH_STACK_SIZE, "the traversal stack must fit the deepest tree");
+
+static inline float SurfaceArea(const AABB& box)
+{
+    glm::vec3 e = box.max - box.min;
+    return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+}
+
+static inline AABB EmptyAABB()
+{
+    return { glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) };
+}
+
+static inline void Grow(AABB& box, const AABB& other)
+{
+    box.min = glm::min(box.min, other.min);
+    box.max = glm::max(box.max, other.max);
+}
+
+static inline bool Overlaps(const AABB& a, const AABB& b)
+{
+    return a.min.x <= b.max.x && a.max.x >= b.min.x
+        && a.min.y <= b.max.y && a.max.y >= b.min.y
+        && a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+/* Slab test, returns the entry distance or FLT_MAX on a miss */
+static inline float IntersectRay(const AABB& box, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance)
+{
+    glm::vec3 t1 = (box.min - origin) * inverseDirection;
+    glm::vec3 t2 = (box.max - origin) * inverseDirection;
+    glm::vec3 tmin = glm::min(t1, t2), tmax = glm::max(t1, t2);
+    float enter = std::max(std::max(tmin.x, tmin.y), std::max(tmin.z, 0.0f));
+    float exit = std::min(std::min(tmax.x, tmax.y), std::min(tmax.z, maxDistance));
+    return enter <= exit ? enter : FLT_MAX;
+}
+
+BVH::BVH()
+    : m_NodesUsed(0), m_Depth(0), m_BuildMilliseconds(0.0), m_RefitMilliseconds(0.0)
+{
+}
+
+void BVH::Build(const std::vector<AABB>& bounds)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    m_Bounds = bounds;
+    unsigned int count = (unsigned int)bounds.size();
+    m_Indices.resize(count);
+    for (unsigned int i = 0; i < count; i++)
+        m_Indices[i] = i;
+
+    /* a binary tree over n leaves never needs more than 2n - 1 nodes */
+    m_Nodes.assign(count > 0 ? 2 * count - 1 : 1, Node());
+    m_NodesUsed = 1;
+    m_Depth = 1;
+    m_Nodes[0].leftFirst = 0;
+    m_Nodes[0].count = count;
+    UpdateNodeBounds(0);
+    if (count > 0)
+        Subdivide(0, 1);
+
+    auto end = std::chrono::high_resolution_clock::now();
+    m_BuildMilliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void BVH::Refit(const std::vector<AABB>& bounds)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    m_Bounds = bounds;
+    /* children are always allocated after their parent,
+       so a reverse sweep visits every node after its children */
+    for (int i = (int)m_NodesUsed - 1; i >= 0; i--)
+    {
+        Node& node = m_Nodes[i];
+        if (node.count > 0)
+        {
+            UpdateNodeBounds(i);
+            continue;
+        }
+        node.bounds = m_Nodes[node.leftFirst].bounds;
+        Grow(node.bounds, m_Nodes[node.leftFirst + 1].bounds);
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    m_RefitMilliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void BVH::UpdateNodeBounds(unsigned int index)
+{
+    Node& node = m_Nodes[index];
+    node.bounds = EmptyAABB();
+    for (unsigned int i = 0; i < node.count; i++)
+        Grow(node.bounds, m_Bounds[m_Indices[node.leftFirst + i]]);
+}
+
+/* Binned SAH: returns the cost of the best split of [node] found over all axes */
+float BVH::FindBestSplit(const Node& node, int& axis, float& position) const
+{
+    float bestCost = FLT_MAX;
+    for (int a = 0; a < 3; a++)
+    {
+        float minCentroid = FLT_MAX, maxCentroid = -FLT_MAX;
+        for (unsigned int i = 0; i < node.count; i++)
+        {
+            float centroid = m_Bounds[m_Indices[node.leftFirst + i]].GetCenter()[a];
+            minCentroid = std::min(minCentroid, centroid);
+            maxCentroid = std::max(maxCentroid, centroid);
+        }
+        if (minCentroid == maxCentroid)
+            continue;
+
+        AABB binBounds[BVH_BINS];
+        unsigned int binCount[BVH_BINS] = {};
+        for (int b = 0; b < BVH_BINS; b++)
+            binBounds[b] = EmptyAABB();
+        float scale = BVH_BINS / (maxCentroid - minCentroid);
+        for (unsigned int i = 0; i < node.count; i++)
+        {
+            const AABB& box = m_Bounds[m_Indices[node.leftFirst + i]];
+            int bin = std::min(BVH_BINS - 1, (int)((box.GetCenter()[a] - minCentroid) * scale));
+            binCount[bin]++;
+            Grow(binBounds[bin], box);
+        }
+
+        /* sweep from both sides to get the area and count left/right of every bin plane */
+        float leftArea[BVH_BINS - 1], rightArea[BVH_BINS - 1];
+        unsigned int leftCount[BVH_BINS - 1], rightCount[BVH_BINS - 1];
+        AABB leftBox = EmptyAABB(), rightBox = EmptyAABB();
+        unsigned int leftSum = 0, rightSum = 0;
+        for (int b = 0; b < BVH_BINS - 1; b++)
+        {
+            leftSum += binCount[b];
+            leftCount[b] = leftSum;
+            Grow(leftBox, binBounds[b]);
+            leftArea[b] = leftSum ? SurfaceArea(leftBox) : 0.0f;
+
+            rightSum += binCount[BVH_BINS - 1 - b];
+            rightCount[BVH_BINS - 2 - b] = rightSum;
+            Grow(rightBox, binBounds[BVH_BINS - 1 - b]);
+            rightArea[BVH_BINS - 2 - b] = rightSum ? SurfaceArea(rightBox) : 0.0f;
+        }
+        for (int b = 0; b < BVH_BINS - 1; b++)
+        {
+            float cost = leftCount[b] * leftArea[b] + rightCount[b] * rightArea[b];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                axis = a;
+                position = minCentroid + (b + 1) / scale;
+            }
+        }
+    }
+    return bestCost;
+}
+
+void BVH::Subdivide(unsigned int index, unsigned int depth)
+{
+    Node& node = m_Nodes[index];
+    m_Depth = std::max(m_Depth, depth);
+    if (node.count <= BVH_MAX_LEAF_SIZE || depth >= BVH_MAX_DEPTH)
+        return;
+
+    int axis = 0;
+    float position = 0.0f;
+    float splitCost = FindBestSplit(node, axis, position);
+    /* stop when splitting is not cheaper than testing every object of the leaf */
+    float leafCost = node.count * SurfaceArea(node.bounds);
+    if (splitCost >= leafCost)
+        return;
+
+    /* partition the index range in place around the split plane */
+    int i = (int)node.leftFirst;
+    int j = i + (int)node.count - 1;
+    while (i <= j)
+    {
+        if (m_Bounds[m_Indices[i]].GetCenter()[axis] < position)
+            i++;
+        else
+            std::swap(m_Indices[i], m_Indices[j--]);
+    }
+    unsigned int leftCount = (unsigned int)i - node.leftFirst;
+    if (leftCount == 0 || leftCount == node.count)
+        return;
+
+    unsigned int left = m_NodesUsed;
+    m_NodesUsed += 2;
+    m_Nodes[left].leftFirst = node.leftFirst;
+    m_Nodes[left].count = leftCount;
+    m_Nodes[left + 1].leftFirst = i;
+    m_Nodes[left + 1].count = node.count - leftCount;
+    node.leftFirst = left;
+    node.count = 0;
+
+    UpdateNodeBounds(left);
+    UpdateNodeBounds(left + 1);
+    Subdivide(left, depth + 1);
+    Subdivide(left + 1, depth + 1);
+}
+
+void BVH::Query(const Frustum& frustum, std::vector<unsigned int>& result) const
+{
+    result.clear();
+    if (m_Indices.empty())
+        return;
+
+    unsigned int stack[BVH_STACK_SIZE];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const Node& node = m_Nodes[stack[--top]];
+        if (!frustum.Intersects(node.bounds))
+            continue;
+        if (node.count > 0)
+        {
+            for (unsigned int i = 0; i < node.count; i++)
+            {
+                unsigned int object = m_Indices[node.leftFirst + i];
+                if (frustum.Intersects(m_Bounds[object]))
+                    result.push_back(object);
+            }
+            continue;
+        }
+        stack[top++] = node.leftFirst;
+        stack[top++] = node.leftFirst + 1;
+    }
+}
+
+void BVH::Query(const AABB& box, std::vector<unsigned int>& result) const
+{
+    result.clear();
+    if (m_Indices.empty())
+        return;
+
+    unsigned int stack[BVH_STACK_SIZE];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const Node& node = m_Nodes[stack[--top]];
+        if (!Overlaps(node.bounds, box))
+            continue;
+        if (node.count > 0)
+        {
+            for (unsigned int i = 0; i < node.count; i++)
+            {
+                unsigned int object = m_Indices[node.leftFirst + i];
+                if (Overlaps(m_Bounds[object], box))
+                    result.push_back(object);
+            }
+            continue;
+        }
+        stack[top++] = node.leftFirst;
+        stack[top++] = node.leftFirst + 1;
+    }
+}
+
+bool BVH::Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+    unsigned int& object, float& distance) const
+{
+    if (m_Indices.empty())
+        return false;
+
+    glm::vec3 inverseDirection = 1.0f / direction;
+    distance = maxDistance;
+    bool hit = false;
+
+    unsigned int stack[BVH_STACK_SIZE];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const Node& node = m_Nodes[stack[--top]];
+        if (IntersectRay(node.bounds, origin, inverseDirection, distance) == FLT_MAX)
+            continue;
+        if (node.count > 0)
+        {
+            for (unsigned int i = 0; i < node.count; i++)
+            {
+                unsigned int candidate = m_Indices[node.leftFirst + i];
+                float t = IntersectRay(m_Bounds[candidate], origin, inverseDirection, distance);
+                if (t < distance)
+                {
+                    distance = t;
+                    object = candidate;
+                    hit = true;
+                }
+            }
+            continue;
+        }
+        /* visit the nearer child first so farther subtrees get pruned by [distance] */
+        float leftT = IntersectRay(m_Nodes[node.leftFirst].bounds, origin, inverseDirection, distance);
+        float rightT = IntersectRay(m_Nodes[node.leftFirst + 1].bounds, origin, inverseDirection, distance);
+        unsigned int nearChild = leftT <= rightT ? node.leftFirst : node.leftFirst + 1;
+        unsigned int farChild = leftT <= rightT ? node.leftFirst + 1 : node.leftFirst;
+        if (std::max(leftT, rightT) != FLT_MAX)
+            stack[top++] = farChild;
+        if (std::min(leftT, rightT) != FLT_MAX)
+            stack[top++] = nearChild;
+    }
+    return hit;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Bounds.h"
+
+class Frustum;
+
+/* Bounding volume hierarchy over object bounds.
+   Nodes live in one flat array, the two children of a node are stored next
+   to each other, so traversal walks contiguous memory. Build() uses the
+   surface area heuristic over binned centroids; Refit() only recomputes
+   bounds bottom-up and keeps the topology, for objects that moved a little. */
+class BVH
+{
+private:
+	struct Node
+	{
+		AABB bounds;
+		unsigned int leftFirst;	// first child for interior nodes, first index for leaves
+		unsigned int count;		// 0 for interior nodes
+	};
+
+	std::vector<Node> m_Nodes;
+	std::vector<unsigned int> m_Indices;	// object indices in leaf order
+	std::vector<AABB> m_Bounds;			// copy of the object bounds
+	unsigned int m_NodesUsed;
+	unsigned int m_Depth;	// levels of the last Build(), the root alone is 1
+
+	double m_BuildMilliseconds;
+	double m_RefitMilliseconds;
+
+	void UpdateNodeBounds(unsigned int node);
+	void Subdivide(unsigned int node, unsigned int depth);
+	float FindBestSplit(const Node& node, int& axis, float& position) const;
+public:
+	BVH();
+
+	/* Builds the tree from scratch over [bounds], object i has bounds[i] */
+	void Build(const std::vector<AABB>& bounds);
+	/* Updates the node bounds for moved objects, same object count as Build() */
+	void Refit(const std::vector<AABB>& bounds);
+
+	/* Indices of the objects touching [frustum] */
+	void Query(const Frustum& frustum, std::vector<unsigned int>& result) const;
+	/* Indices of the objects overlapping [box] */
+	void Query(const AABB& box, std::vector<unsigned int>& result) const;
+	/* Closest object whose bounds the ray hits within [maxDistance]; false if none */
+	bool Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+		unsigned int& object, float& distance) const;
+
+	inline unsigned int GetNodeCount() const { return m_NodesUsed; }
+	inline unsigned int GetDepth() const { return m_Depth; }
+	inline double GetBuildMilliseconds() const { return m_BuildMilliseconds; }
+	inline double GetRefitMilliseconds() const { return m_RefitMilliseconds; }
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include <glm/glm.hpp>
+
+/* Axis aligned bounding box */
+struct AABB
+{
+	glm::vec3 min;
+	glm::vec3 max;
+
+	inline glm::vec3 GetCenter() const { return (min + max) * 0.5f; }
+	inline glm::vec3 GetExtents() const { return (max - min) * 0.5f; }
+};
+
+struct BoundingSphere
+{
+	glm::vec3 center;
+	float radius;
+};
+
+/* Bounds of [box] after the affine transform [matrix] (Arvo's method) */
+inline AABB TransformAABB(const AABB& box, const glm::mat4& matrix)
+{
+	glm::vec3 center = glm::vec3(matrix * glm::vec4(box.GetCenter(), 1.0f));
+	glm::vec3 extents = box.GetExtents();
+	glm::vec3 worldExtents;
+	for (int i = 0; i < 3; i++)
+		worldExtents[i] = std::abs(matrix[0][i]) * extents.x + std::abs(matrix[1][i]) * extents.y + std::abs(matrix[2][i]) * extents.z;
+	return { center - worldExtents, center + worldExtents };
+}
+
+/* Boxes stored as centers and extents in separate arrays, the input of the SIMD culling kernels */
+class AABBArray
+{
+private:
+	std::vector<float> m_CenterX, m_CenterY, m_CenterZ;
+	std::vector<float> m_ExtentX, m_ExtentY, m_ExtentZ;
+public:
+	inline unsigned int Add(const AABB& box)
+	{
+		unsigned int index = GetCount();
+		m_CenterX.push_back(0.0f); m_CenterY.push_back(0.0f); m_CenterZ.push_back(0.0f);
+		m_ExtentX.push_back(0.0f); m_ExtentY.push_back(0.0f); m_ExtentZ.push_back(0.0f);
+		Set(index, box);
+		return index;
+	}
+
+	inline void Set(unsigned int index, const AABB& box)
+	{
+		glm::vec3 center = box.GetCenter(), extents = box.GetExtents();
+		m_CenterX[index] = center.x; m_CenterY[index] = center.y; m_CenterZ[index] = center.z;
+		m_ExtentX[index] = extents.x; m_ExtentY[index] = extents.y; m_ExtentZ[index] = extents.z;
+	}
+
+	inline AABB Get(unsigned int index) const
+	{
+		glm::vec3 center(m_CenterX[index], m_CenterY[index], m_CenterZ[index]);
+		glm::vec3 extents(m_ExtentX[index], m_ExtentY[index], m_ExtentZ[index]);
+		return { center - extents, center + extents };
+	}
+
+	inline void Clear()
+	{
+		m_CenterX.clear(); m_CenterY.clear(); m_CenterZ.clear();
+		m_ExtentX.clear(); m_ExtentY.clear(); m_ExtentZ.clear();
+	}
+
+	inline unsigned int GetCount() const { return (unsigned int)m_CenterX.size(); }
+	inline const float* GetCenterX() const { return m_CenterX.data(); }
+	inline const float* GetCenterY() const { return m_CenterY.data(); }
+	inline const float* GetCenterZ() const { return m_CenterZ.data(); }
+	inline const float* GetExtentX() const { return m_ExtentX.data(); }
+	inline const float* GetExtentY() const { return m_ExtentY.data(); }
+	inline const float* GetExtentZ() const { return m_ExtentZ.data(); }
+};
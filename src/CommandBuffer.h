@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+
+class PipelineState;
+class Material;
+class UniformBuffer;
+class IndexBuffer;
+
+enum class CommandType : uint16_t
+{
+	BindPipeline,
+	BindMaterial,
+	BindUniformBuffer,
+	SetUniformInt,
+	SetUniformFloat,
+	SetUniformVec4,
+	SetUniformMat4,
+	Draw,
+	DrawIndexed
+};
+
+/* Every command is a header followed by its payload, packed back to back */
+struct CommandHeader
+{
+	CommandType type;
+	uint16_t size;	// payload bytes
+};
+
+struct BindPipelineCommand { const PipelineState* pipeline; };
+struct BindMaterialCommand { Material* material; };
+struct BindUniformBufferCommand { const UniformBuffer* buffer; unsigned int binding, offset, size; };
+template<typename T>
+struct SetUniformCommand { Shader* shader; UniformHandle handle; T value; };
+struct DrawArraysCommand { unsigned int first, vertexCount; };
+struct DrawIndexedCommand { const IndexBuffer* indices; unsigned int indexCount; };
+
+/* CPU side recording of draw state, replayed later by Renderer::Execute().
+   Recording makes no GL call, so any thread can fill its own buffer; the
+   buffers are then appended in order and executed on the GL thread.
+   Uniform handles have to be resolved on the GL thread beforehand. */
+class CommandBuffer
+{
+private:
+	std::vector<unsigned char> m_Data;
+	unsigned int m_CommandCount;
+
+	template<typename T>
+	void Push(CommandType type, const T& payload)
+	{
+		static_assert(sizeof(T) <= 0xFFFF, "command payload too large");
+		CommandHeader header = { type, (uint16_t)sizeof(T) };
+		size_t offset = m_Data.size();
+		m_Data.resize(offset + sizeof(header) + sizeof(T));
+		std::memcpy(&m_Data[offset], &header, sizeof(header));
+		std::memcpy(&m_Data[offset + sizeof(header)], &payload, sizeof(T));
+		m_CommandCount++;
+	}
+public:
+	CommandBuffer()
+		: m_CommandCount(0) {}
+
+	void BindPipeline(const PipelineState& pipeline) { Push(CommandType::BindPipeline, BindPipelineCommand{ &pipeline }); }
+	void BindMaterial(Material& material) { Push(CommandType::BindMaterial, BindMaterialCommand{ &material }); }
+	void BindUniformBuffer(const UniformBuffer& buffer, unsigned int binding, unsigned int offset, unsigned int size)
+	{
+		Push(CommandType::BindUniformBuffer, BindUniformBufferCommand{ &buffer, binding, offset, size });
+	}
+
+	void SetUniform(Shader& shader, UniformHandle handle, int value) { Push(CommandType::SetUniformInt, SetUniformCommand<int>{ &shader, handle, value }); }
+	void SetUniform(Shader& shader, UniformHandle handle, float value) { Push(CommandType::SetUniformFloat, SetUniformCommand<float>{ &shader, handle, value }); }
+	void SetUniform(Shader& shader, UniformHandle handle, const glm::vec4& value) { Push(CommandType::SetUniformVec4, SetUniformCommand<glm::vec4>{ &shader, handle, value }); }
+	void SetUniform(Shader& shader, UniformHandle handle, const glm::mat4& value) { Push(CommandType::SetUniformMat4, SetUniformCommand<glm::mat4>{ &shader, handle, value }); }
+
+	void Draw(unsigned int vertexCount, unsigned int first = 0) { Push(CommandType::Draw, DrawArraysCommand{ first, vertexCount }); }
+	void DrawIndexed(const IndexBuffer& indices, unsigned int indexCount) { Push(CommandType::DrawIndexed, DrawIndexedCommand{ &indices, indexCount }); }
+
+	/* Adds the commands of [other] after the ones already recorded */
+	void Append(const CommandBuffer& other)
+	{
+		m_Data.insert(m_Data.end(), other.m_Data.begin(), other.m_Data.end());
+		m_CommandCount += other.m_CommandCount;
+	}
+
+	/* Keeps the memory for the next frame */
+	void Clear()
+	{
+		m_Data.clear();
+		m_CommandCount = 0;
+	}
+
+	inline const unsigned char* GetData() const { return m_Data.data(); }
+	inline size_t GetSize() const { return m_Data.size(); }
+	inline unsigned int GetCommandCount() const { return m_CommandCount; }
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+// Generated by tools/EmbedShaders.cpp from res/shaders, do not edit
+
+#include "ShaderPreprocessor.h"
+
+inline constexpr EmbeddedShader g_EmbeddedShaders[] =
+{
+	{
+		"Basic",
+		R"glsl(#version 330 core
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec2 texCoord;
+out vec2 v_TexCoord;
+uniform mat4 transformations;
+void main()
+{
+   gl_Position = transformations * position;
+   v_TexCoord = texCoord;
+};
+)glsl",
+		R"glsl(#version 330 core
+layout(location = 0) out vec4 color;
+in vec2 v_TexCoord;
+layout(std140) uniform Material
+{
+	vec4 u_Color;
+};
+uniform sampler2D u_Texture;
+void main()
+{
+#if defined(NO_TEXTURE)
+	color = u_Color;
+#elif defined(NO_COLOR)
+	color = texture(u_Texture, v_TexCoord);
+#else
+	vec4 texColor = texture(u_Texture, v_TexCoord);
+	color = texColor * u_Color;
+#endif
+};
+)glsl"
+	},
+};
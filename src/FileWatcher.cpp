@@ -0,0 +1,118 @@
+#include "FileWatcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <unordered_map>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+/* How long the watch thread sleeps between checks for shutdown / modification times */
+#define FILE_WATCH_INTERVAL_MS 100
+
+FileWatcher::FileWatcher(const std::string& directory)
+    : m_Directory(directory), m_Running(true)
+{
+    m_Thread = std::thread(&FileWatcher::Run, this);
+}
+
+FileWatcher::~FileWatcher()
+{
+    m_Running = false;
+    if (m_Thread.joinable())
+        m_Thread.join();
+}
+
+void FileWatcher::AddChange(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (std::find(m_Changes.begin(), m_Changes.end(), path) == m_Changes.end())
+        m_Changes.push_back(path);
+}
+
+std::vector<std::string> FileWatcher::PollChanges()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    std::vector<std::string> changes;
+    changes.swap(m_Changes);
+    return changes;
+}
+
+#ifdef __linux__
+
+void FileWatcher::Run()
+{
+    /* inotify_init1() creates a non-blocking inotify instance,
+       IN_CLOSE_WRITE catches in-place saves and IN_MOVED_TO editors that save by renaming */
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0 || inotify_add_watch(fd, m_Directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        std::cout << "Warning: can't watch ' " << m_Directory << " ' " << std::endl;
+        if (fd >= 0)
+            close(fd);
+        return;
+    }
+
+    alignas(inotify_event) char buffer[4096];
+    while (m_Running)
+    {
+        /* poll() with a timeout so the destructor can stop the thread */
+        pollfd pfd = { fd, POLLIN, 0 };
+        if (poll(&pfd, 1, FILE_WATCH_INTERVAL_MS) <= 0)
+            continue;
+
+        ssize_t length;
+        while ((length = read(fd, buffer, sizeof(buffer))) > 0)
+        {
+            for (char* ptr = buffer; ptr < buffer + length; )
+            {
+                const inotify_event* event = (const inotify_event*)ptr;
+                if (event->len > 0)
+                    AddChange((std::filesystem::path(m_Directory) / event->name).generic_string());
+                ptr += sizeof(inotify_event) + event->len;
+            }
+        }
+    }
+    close(fd);
+}
+
+#else
+
+void FileWatcher::Run()
+{
+    /* Without inotify the directory is scanned for newer modification times */
+    std::unordered_map<std::string, std::filesystem::file_time_type> times;
+    bool first = true;
+    while (m_Running)
+    {
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator(m_Directory, error))
+        {
+            if (!entry.is_regular_file(error))
+                continue;
+            std::string path = entry.path().generic_string();
+            std::filesystem::file_time_type time = entry.last_write_time(error);
+            auto it = times.find(path);
+            if (it == times.end())
+            {
+                times[path] = time;
+                if (!first)
+                    AddChange(path);
+            }
+            else if (it->second != time)
+            {
+                it->second = time;
+                AddChange(path);
+            }
+        }
+        first = false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(FILE_WATCH_INTERVAL_MS));
+    }
+}
+
+#endif
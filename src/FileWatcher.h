@@ -0,0 +1,32 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* Watches a directory on a background thread and collects the paths of files
+   written to it. Uses inotify on Linux and polls modification times elsewhere. */
+class FileWatcher
+{
+private:
+	std::string m_Directory;
+	std::thread m_Thread;
+	std::atomic<bool> m_Running;
+
+	std::mutex m_Mutex;
+	std::vector<std::string> m_Changes;
+
+	void AddChange(const std::string& path);
+	void Run();
+public:
+	FileWatcher(const std::string& directory);
+	~FileWatcher();
+
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	/* Returns the files changed since the last call, each path once */
+	std::vector<std::string> PollChanges();
+};
@@ -0,0 +1,155 @@
+#include "Frustum.h"
+
+#include "Simd.h"
+
+Frustum::Frustum()
+{
+    for (int i = 0; i < 6; i++)
+        m_Planes[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+Frustum::Frustum(const glm::mat4& viewProjection)
+{
+    /* glm is column major, row i is (m[0][i], m[1][i], m[2][i], m[3][i]);
+       a point is inside when -w <= x, y, z <= w in clip space */
+    glm::vec4 row[4];
+    for (int i = 0; i < 4; i++)
+        row[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+
+    m_Planes[LEFT]       = row[3] + row[0];
+    m_Planes[RIGHT]      = row[3] - row[0];
+    m_Planes[BOTTOM]     = row[3] + row[1];
+    m_Planes[TOP]        = row[3] - row[1];
+    m_Planes[NEAR_PLANE] = row[3] + row[2];
+    m_Planes[FAR_PLANE]  = row[3] - row[2];
+
+    /* normalized so the plane equation gives real distances for sphere tests */
+    for (int i = 0; i < 6; i++)
+        m_Planes[i] /= glm::length(glm::vec3(m_Planes[i]));
+}
+
+bool Frustum::Intersects(const AABB& box) const
+{
+    glm::vec3 center = box.GetCenter(), extents = box.GetExtents();
+    for (int i = 0; i < 6; i++)
+    {
+        glm::vec3 normal(m_Planes[i]);
+        /* projected radius of the box on the plane normal */
+        float radius = glm::dot(glm::abs(normal), extents);
+        if (glm::dot(normal, center) + m_Planes[i].w + radius < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+bool Frustum::Intersects(const BoundingSphere& sphere) const
+{
+    for (int i = 0; i < 6; i++)
+    {
+        if (glm::dot(glm::vec3(m_Planes[i]), sphere.center) + m_Planes[i].w + sphere.radius < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+/* Appends the indices of the set bits of [mask] (lane i = object base + i) */
+static inline void AppendVisible(unsigned int mask, unsigned int base, std::vector<unsigned int>& visible)
+{
+    while (mask)
+    {
+        unsigned int lane = 0;
+        while (!(mask & (1u << lane)))
+            lane++;
+        visible.push_back(base + lane);
+        mask &= mask - 1;
+    }
+}
+
+unsigned int Frustum::Cull(const AABBArray& boxes, std::vector<unsigned int>& visible) const
+{
+    visible.clear();
+    const unsigned int count = boxes.GetCount();
+    const float* cx = boxes.GetCenterX(); const float* cy = boxes.GetCenterY(); const float* cz = boxes.GetCenterZ();
+    const float* ex = boxes.GetExtentX(); const float* ey = boxes.GetExtentY(); const float* ez = boxes.GetExtentZ();
+    unsigned int i = 0;
+
+#if defined(SIMD_AVX2)
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(cx + i), y = _mm256_loadu_ps(cy + i), z = _mm256_loadu_ps(cz + i);
+        __m256 hx = _mm256_loadu_ps(ex + i), hy = _mm256_loadu_ps(ey + i), hz = _mm256_loadu_ps(ez + i);
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; p++)
+        {
+            const glm::vec4& plane = m_Planes[p];
+            /* distance of the center plus the box radius along the normal */
+            __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(plane.x)),
+                                                   _mm256_mul_ps(y, _mm256_set1_ps(plane.y))),
+                                     _mm256_add_ps(_mm256_mul_ps(z, _mm256_set1_ps(plane.z)), _mm256_set1_ps(plane.w)));
+            __m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(hx, _mm256_set1_ps(std::abs(plane.x))),
+                                                   _mm256_mul_ps(hy, _mm256_set1_ps(std::abs(plane.y)))),
+                                     _mm256_mul_ps(hz, _mm256_set1_ps(std::abs(plane.z))));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(d, r), _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+        AppendVisible((unsigned int)_mm256_movemask_ps(inside), i, visible);
+    }
+#endif
+#if defined(SIMD_SSE2) || defined(SIMD_AVX2)
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(cx + i), y = _mm_loadu_ps(cy + i), z = _mm_loadu_ps(cz + i);
+        __m128 hx = _mm_loadu_ps(ex + i), hy = _mm_loadu_ps(ey + i), hz = _mm_loadu_ps(ez + i);
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; p++)
+        {
+            const glm::vec4& plane = m_Planes[p];
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.x)), _mm_mul_ps(y, _mm_set1_ps(plane.y))),
+                                  _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+            __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(hx, _mm_set1_ps(std::abs(plane.x))),
+                                             _mm_mul_ps(hy, _mm_set1_ps(std::abs(plane.y)))),
+                                  _mm_mul_ps(hz, _mm_set1_ps(std::abs(plane.z))));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(d, r), _mm_setzero_ps()));
+        }
+        AppendVisible((unsigned int)_mm_movemask_ps(inside), i, visible);
+    }
+#endif
+    for (; i < count; i++)
+    {
+        if (Intersects(boxes.Get(i)))
+            visible.push_back(i);
+    }
+    return (unsigned int)visible.size();
+}
+
+unsigned int Frustum::Cull(const std::vector<BoundingSphere>& spheres, std::vector<unsigned int>& visible) const
+{
+    visible.clear();
+    const unsigned int count = (unsigned int)spheres.size();
+    unsigned int i = 0;
+
+#if defined(SIMD_SSE2) || defined(SIMD_AVX2)
+    static_assert(sizeof(BoundingSphere) == 4 * sizeof(float), "spheres are loaded as float4");
+    for (; i + 4 <= count; i += 4)
+    {
+        /* four (x, y, z, radius) spheres transposed into x, y, z and radius lanes */
+        const float* data = &spheres[i].center.x;
+        __m128 x = _mm_loadu_ps(data), y = _mm_loadu_ps(data + 4), z = _mm_loadu_ps(data + 8), r = _mm_loadu_ps(data + 12);
+        _MM_TRANSPOSE4_PS(x, y, z, r);
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; p++)
+        {
+            const glm::vec4& plane = m_Planes[p];
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.x)), _mm_mul_ps(y, _mm_set1_ps(plane.y))),
+                                  _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(d, r), _mm_setzero_ps()));
+        }
+        AppendVisible((unsigned int)_mm_movemask_ps(inside), i, visible);
+    }
+#endif
+    for (; i < count; i++)
+    {
+        if (Intersects(spheres[i]))
+            visible.push_back(i);
+    }
+    return (unsigned int)visible.size();
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Bounds.h"
+
+/* View frustum as six inward facing planes (x, y, z = normal, w = distance) */
+class Frustum
+{
+private:
+	glm::vec4 m_Planes[6];
+public:
+	enum PlaneIndex { LEFT = 0, RIGHT, BOTTOM, TOP, NEAR_PLANE, FAR_PLANE };
+
+	Frustum();
+	/* Extracts the planes from a projection * view matrix (Gribb/Hartmann) */
+	Frustum(const glm::mat4& viewProjection);
+
+	bool Intersects(const AABB& box) const;
+	bool Intersects(const BoundingSphere& sphere) const;
+
+	/* Writes the indices of the boxes that touch the frustum to [visible],
+	   testing 4 (SSE2) or 8 (AVX2) boxes per iteration; returns the visible count */
+	unsigned int Cull(const AABBArray& boxes, std::vector<unsigned int>& visible) const;
+	unsigned int Cull(const std::vector<BoundingSphere>& spheres, std::vector<unsigned int>& visible) const;
+
+	inline const glm::vec4& GetPlane(int index) const { return m_Planes[index]; }
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/* 64-bit FNV-1a, used to key cached data on disk */
+#define FNV1A_OFFSET_BASIS 14695981039346656037ull
+#define FNV1A_PRIME 1099511628211ull
+
+inline unsigned long long HashBytes(const void* data, std::size_t size, unsigned long long seed = FNV1A_OFFSET_BASIS)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	unsigned long long hash = seed;
+	for (std::size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= FNV1A_PRIME;
+	}
+	return hash;
+}
+
+inline unsigned long long HashString(const std::string& str, unsigned long long seed = FNV1A_OFFSET_BASIS)
+{
+	// the length is mixed in too so that ("ab", "c") and ("a", "bc") differ
+	std::size_t length = str.size();
+	seed = HashBytes(&length, sizeof(length), seed);
+	return HashBytes(str.data(), str.size(), seed);
+}
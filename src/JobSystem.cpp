@@ -0,0 +1,250 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+
+/* Worker index of the current thread in the system that owns it; threads
+   outside the pool push into the deque of worker 0 */
+static thread_local const JobSystem* s_System = nullptr;
+static thread_local unsigned int s_WorkerIndex = 0;
+/* Time of the jobs executed inside the job running on this thread, by
+   Wait() or ParallelFor(), which the outer job doesn't count as its own */
+static thread_local uint64_t s_NestedNanoseconds = 0;
+
+JobSystem::JobSystem(unsigned int workerCount /*= 0*/)
+    : m_Queued(0), m_Stop(false), m_StatsStart(std::chrono::steady_clock::now())
+{
+    if (workerCount == 0)
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+
+    for (unsigned int i = 0; i < workerCount; i++)
+    {
+        m_Workers.emplace_back(new Worker());
+        m_Workers.back()->executed = 0;
+        m_Workers.back()->steals = 0;
+        m_Workers.back()->busyNanoseconds = 0;
+    }
+
+    s_System = this;
+    s_WorkerIndex = 0;
+    for (unsigned int i = 1; i < workerCount; i++)
+        m_Threads.emplace_back(&JobSystem::WorkerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+    /* queued jobs still run: a dropped one would leak what it owns, such as
+       the frame of a coroutine waiting to be resumed */
+    while (ExecuteOne())
+        ;
+    {
+        std::lock_guard<std::mutex> lock(m_SleepMutex);
+        m_Stop = true;
+    }
+    m_WakeUp.notify_all();
+    for (std::thread& thread : m_Threads)
+        thread.join();
+    /* and whatever the last of them queued for worker 0 */
+    while (ExecuteOne())
+        ;
+    if (s_System == this)
+        s_System = nullptr;
+}
+
+void JobSystem::WorkerLoop(unsigned int index)
+{
+    s_System = this;
+    s_WorkerIndex = index;
+    while (true)
+    {
+        JobHandle job = Pop(index);
+        if (job)
+        {
+            Execute(job, index);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(m_SleepMutex);
+        /* on shutdown a worker only leaves once the queues are empty */
+        if (m_Stop && m_Queued == 0)
+            return;
+        m_WakeUp.wait(lock, [this]() { return m_Queued > 0 || m_Stop; });
+    }
+}
+
+void JobSystem::Push(const JobHandle& job)
+{
+    Worker& worker = *m_Workers[s_System == this ? s_WorkerIndex : 0];
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.jobs.push_back(job);
+    }
+    m_Queued++;
+    /* taking the lock orders the increment against a worker about to sleep */
+    {
+        std::lock_guard<std::mutex> lock(m_SleepMutex);
+    }
+    m_WakeUp.notify_one();
+}
+
+JobHandle JobSystem::Pop(unsigned int index)
+{
+    JobHandle job;
+    {
+        /* own jobs newest first */
+        Worker& worker = *m_Workers[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (!worker.jobs.empty())
+        {
+            job = std::move(worker.jobs.back());
+            worker.jobs.pop_back();
+        }
+    }
+    /* otherwise the oldest job of another worker, the one most likely to spawn more */
+    for (unsigned int i = 1; !job && i < m_Workers.size(); i++)
+    {
+        Worker& victim = *m_Workers[(index + i) % m_Workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty())
+        {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            m_Workers[index]->steals++;
+        }
+    }
+    if (job)
+        m_Queued--;
+    return job;
+}
+
+void JobSystem::Execute(const JobHandle& job, unsigned int index)
+{
+    uint64_t outerNested = s_NestedNanoseconds;
+    s_NestedNanoseconds = 0;
+    auto start = std::chrono::steady_clock::now();
+    if (job->function)
+        job->function();
+    auto end = std::chrono::steady_clock::now();
+
+    /* jobs run inside this one counted their own time already */
+    uint64_t elapsed = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    Worker& worker = *m_Workers[index];
+    worker.busyNanoseconds += elapsed - std::min(elapsed, s_NestedNanoseconds);
+    s_NestedNanoseconds = outerNested + elapsed;
+    worker.executed++;
+    Finish(job.get());
+}
+
+void JobSystem::Finish(Job* job)
+{
+    if (--job->unfinished > 0)
+        return;
+
+    std::vector<JobHandle> continuations;
+    {
+        std::lock_guard<std::mutex> lock(job->mutex);
+        job->completed.store(true, std::memory_order_release);
+        continuations.swap(job->continuations);
+    }
+    for (const JobHandle& continuation : continuations)
+    {
+        if (--continuation->pending == 0)
+            Push(continuation);
+    }
+    if (job->parent)
+        Finish(job->parent.get());
+}
+
+JobHandle JobSystem::Create(std::function<void()> function, const JobHandle& parent /*= nullptr*/)
+{
+    JobHandle job = std::make_shared<Job>();
+    job->function = std::move(function);
+    job->parent = parent;
+    job->unfinished = 1;
+    job->pending = 1;
+    job->completed = false;
+    if (parent)
+        parent->unfinished++;
+    return job;
+}
+
+void JobSystem::AddDependency(const JobHandle& job, const JobHandle& dependency)
+{
+    std::lock_guard<std::mutex> lock(dependency->mutex);
+    if (dependency->completed)
+        return;
+    job->pending++;
+    dependency->continuations.push_back(job);
+}
+
+void JobSystem::Run(const JobHandle& job)
+{
+    /* drops the reference Create() took, the last one to go queues the job */
+    if (--job->pending == 0)
+        Push(job);
+}
+
+void JobSystem::Wait(const JobHandle& job)
+{
+    unsigned int index = s_System == this ? s_WorkerIndex : 0;
+    while (!IsCompleted(job))
+    {
+        JobHandle next = Pop(index);
+        if (next)
+            Execute(next, index);
+        else
+            std::this_thread::yield();
+    }
+}
+
+bool JobSystem::ExecuteOne()
+{
+    unsigned int index = s_System == this ? s_WorkerIndex : 0;
+    JobHandle job = Pop(index);
+    if (!job)
+        return false;
+    Execute(job, index);
+    return true;
+}
+
+void JobSystem::ParallelFor(unsigned int count, unsigned int grainSize, const std::function<void(unsigned int, unsigned int)>& function)
+{
+    if (count == 0)
+        return;
+    grainSize = std::max(1u, grainSize);
+    if (count <= grainSize || m_Workers.size() == 1)
+    {
+        function(0, count);
+        return;
+    }
+
+    JobHandle group = Create(nullptr);
+    for (unsigned int begin = 0; begin < count; begin += grainSize)
+    {
+        unsigned int end = std::min(begin + grainSize, count);
+        Run(Create([&function, begin, end]() { function(begin, end); }, group));
+    }
+    Run(group);
+    Wait(group);
+}
+
+std::vector<WorkerStats> JobSystem::GetStats() const
+{
+    double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_StatsStart).count();
+    std::vector<WorkerStats> stats;
+    for (const std::unique_ptr<Worker>& worker : m_Workers)
+    {
+        double busy = worker->busyNanoseconds / 1e6;
+        stats.push_back({ worker->executed, worker->steals, busy, elapsed > 0.0 ? busy / elapsed : 0.0 });
+    }
+    return stats;
+}
+
+void JobSystem::ResetStats()
+{
+    for (const std::unique_ptr<Worker>& worker : m_Workers)
+    {
+        worker->executed = 0;
+        worker->steals = 0;
+        worker->busyNanoseconds = 0;
+    }
+    m_StatsStart = std::chrono::steady_clock::now();
+}
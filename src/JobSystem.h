@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct Job;
+typedef std::shared_ptr<Job> JobHandle;
+
+/* One unit of work. A job completes when its function has run and all of
+   its children completed; jobs depending on it start after that. */
+struct Job
+{
+	std::function<void()> function;
+	JobHandle parent;
+	std::atomic<unsigned int> unfinished;	// itself plus running children
+	std::atomic<unsigned int> pending;		// unfinished dependencies, plus one until Run()
+	std::atomic<bool> completed;
+
+	std::mutex mutex;						// guards [continuations] against completion
+	std::vector<JobHandle> continuations;	// jobs waiting on this one
+};
+
+struct WorkerStats
+{
+	uint64_t jobs;
+	uint64_t steals;
+	double busyMilliseconds;
+	double utilization;		// busy share of the time since ResetStats()
+};
+
+/* Work-stealing thread pool.
+   Every worker owns a deque: it pushes and pops its own jobs at the back
+   (most recent first, still warm in cache) while idle workers steal from
+   the front of the others. The thread that created the system is worker 0
+   and helps out while it waits. Jobs form graphs through children (a parent
+   completes after them) and dependencies (a job starts after them). */
+class JobSystem
+{
+private:
+	struct alignas(64) Worker
+	{
+		std::mutex mutex;
+		std::deque<JobHandle> jobs;
+		std::atomic<uint64_t> executed;
+		std::atomic<uint64_t> steals;
+		std::atomic<uint64_t> busyNanoseconds;
+	};
+
+	std::vector<std::unique_ptr<Worker>> m_Workers;
+	std::vector<std::thread> m_Threads;
+	std::atomic<unsigned int> m_Queued;
+	std::atomic<bool> m_Stop;
+	std::mutex m_SleepMutex;
+	std::condition_variable m_WakeUp;
+	std::chrono::steady_clock::time_point m_StatsStart;
+
+	void WorkerLoop(unsigned int index);
+	void Push(const JobHandle& job);
+	JobHandle Pop(unsigned int worker);
+	void Execute(const JobHandle& job, unsigned int worker);
+	void Finish(Job* job);
+public:
+	/* [workerCount] includes the calling thread, 0 = one per core */
+	JobSystem(unsigned int workerCount = 0);
+	/* Runs the jobs still queued, then stops the workers */
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	/* Creates a job that doesn't run before Run(); [parent] won't complete before it,
+	   so children are created before Run(parent) or from inside the parent */
+	JobHandle Create(std::function<void()> function, const JobHandle& parent = nullptr);
+	/* [job] starts only once [dependency] completed; call before Run(job) */
+	void AddDependency(const JobHandle& job, const JobHandle& dependency);
+	/* Queues [job], it starts as soon as its dependencies completed */
+	void Run(const JobHandle& job);
+	/* Executes other jobs until [job] completed */
+	void Wait(const JobHandle& job);
+	/* Executes one queued job on the calling thread, false if there was none */
+	bool ExecuteOne();
+
+	/* Calls function(begin, end) over [0, count) in ranges of about [grainSize], returns when all ran */
+	void ParallelFor(unsigned int count, unsigned int grainSize, const std::function<void(unsigned int, unsigned int)>& function);
+
+	inline bool IsCompleted(const JobHandle& job) const { return job->completed.load(std::memory_order_acquire); }
+	inline unsigned int GetWorkerCount() const { return (unsigned int)m_Workers.size(); }
+
+	/* Per worker counters since the last ResetStats() */
+	std::vector<WorkerStats> GetStats() const;
+	void ResetStats();
+};
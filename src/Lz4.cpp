@@ -0,0 +1,188 @@
+#include "Lz4.h"
+
+#include <cstdint>
+#include <cstring>
+
+#define LZ4_MIN_MATCH 4
+/* The format ends every block with at least this many literals ... */
+#define LZ4_LAST_LITERALS 5
+/* ... and starts no match closer than this to the end */
+#define LZ4_MATCH_LIMIT 12
+#define LZ4_MAX_OFFSET 65535
+#define LZ4_HASH_LOG 12
+
+static inline uint32_t Read32(const unsigned char* p)
+{
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline uint32_t Hash(uint32_t sequence)
+{
+    return (sequence * 2654435761u) >> (32 - LZ4_HASH_LOG);
+}
+
+/* Writes the 255-continued remainder of a length that didn't fit its token nibble */
+static inline bool WriteLength(size_t length, unsigned char*& out, const unsigned char* end)
+{
+    for (; length >= 255; length -= 255)
+    {
+        if (out >= end)
+            return false;
+        *out++ = 255;
+    }
+    if (out >= end)
+        return false;
+    *out++ = (unsigned char)length;
+    return true;
+}
+
+static inline bool WriteSequence(const unsigned char* literals, size_t literalCount, size_t offset, size_t matchLength,
+    unsigned char*& out, const unsigned char* end)
+{
+    if (out >= end)
+        return false;
+    unsigned char* token = out++;
+    *token = (unsigned char)((literalCount >= 15 ? 15 : literalCount) << 4);
+    if (literalCount >= 15 && !WriteLength(literalCount - 15, out, end))
+        return false;
+    if ((size_t)(end - out) < literalCount)
+        return false;
+    if (literalCount > 0)
+        std::memcpy(out, literals, literalCount);
+    out += literalCount;
+
+    /* the last sequence carries literals only */
+    if (matchLength == 0)
+        return true;
+    if (end - out < 2)
+        return false;
+    *out++ = (unsigned char)(offset & 0xFF);
+    *out++ = (unsigned char)(offset >> 8);
+    size_t length = matchLength - LZ4_MIN_MATCH;
+    *token |= (unsigned char)(length >= 15 ? 15 : length);
+    if (length >= 15 && !WriteLength(length - 15, out, end))
+        return false;
+    return true;
+}
+
+size_t Lz4::CompressBound(size_t size)
+{
+    return size + size / 255 + 16;
+}
+
+size_t Lz4::Compress(const char* source, size_t size, char* destination, size_t capacity)
+{
+    const unsigned char* in = (const unsigned char*)source;
+    unsigned char* out = (unsigned char*)destination;
+    const unsigned char* end = out + capacity;
+
+    size_t anchor = 0;
+    if (size > LZ4_MATCH_LIMIT)
+    {
+        uint32_t table[1 << LZ4_HASH_LOG] = {};
+        const size_t matchLimit = size - LZ4_MATCH_LIMIT;
+        const size_t extendLimit = size - LZ4_LAST_LITERALS;
+        size_t i = 0;
+        while (i < matchLimit)
+        {
+            uint32_t sequence = Read32(in + i);
+            uint32_t& slot = table[Hash(sequence)];
+            size_t candidate = slot;
+            slot = (uint32_t)i;
+            if (candidate >= i || i - candidate > LZ4_MAX_OFFSET || Read32(in + candidate) != sequence)
+            {
+                /* skip faster through data that doesn't compress */
+                i += 1 + ((i - anchor) >> 6);
+                continue;
+            }
+
+            while (i > anchor && candidate > 0 && in[i - 1] == in[candidate - 1])
+            {
+                i--;
+                candidate--;
+            }
+            size_t length = LZ4_MIN_MATCH;
+            while (i + length < extendLimit && in[i + length] == in[candidate + length])
+                length++;
+
+            if (!WriteSequence(in + anchor, i - anchor, i - candidate, length, out, end))
+                return 0;
+            i += length;
+            anchor = i;
+            if (i < matchLimit)
+                table[Hash(Read32(in + i - 2))] = (uint32_t)(i - 2);
+        }
+    }
+    if (!WriteSequence(in + anchor, size - anchor, 0, 0, out, end))
+        return 0;
+    return (size_t)(out - (unsigned char*)destination);
+}
+
+bool Lz4::Decompress(const char* source, size_t sourceSize, char* destination, size_t size)
+{
+    const unsigned char* in = (const unsigned char*)source;
+    const unsigned char* inEnd = in + sourceSize;
+    unsigned char* out = (unsigned char*)destination;
+    unsigned char* outEnd = out + size;
+
+    while (in < inEnd)
+    {
+        unsigned int token = *in++;
+        size_t literalCount = token >> 4;
+        if (literalCount == 15)
+        {
+            unsigned char extra;
+            do
+            {
+                if (in >= inEnd)
+                    return false;
+                extra = *in++;
+                literalCount += extra;
+            } while (extra == 255);
+        }
+        if ((size_t)(inEnd - in) < literalCount || (size_t)(outEnd - out) < literalCount)
+            return false;
+        if (literalCount > 0)
+            std::memcpy(out, in, literalCount);
+        in += literalCount;
+        out += literalCount;
+        if (in == inEnd)
+            break;
+
+        if (inEnd - in < 2)
+            return false;
+        size_t offset = (size_t)in[0] | ((size_t)in[1] << 8);
+        in += 2;
+        if (offset == 0 || offset > (size_t)(out - (unsigned char*)destination))
+            return false;
+        size_t length = token & 15;
+        if (length == 15)
+        {
+            unsigned char extra;
+            do
+            {
+                if (in >= inEnd)
+                    return false;
+                extra = *in++;
+                length += extra;
+            } while (extra == 255);
+        }
+        length += LZ4_MIN_MATCH;
+        if ((size_t)(outEnd - out) < length)
+            return false;
+
+        const unsigned char* match = out - offset;
+        if (offset >= length)
+            std::memcpy(out, match, length);
+        else
+        {
+            /* overlapping copy repeats the last [offset] bytes */
+            for (size_t k = 0; k < length; k++)
+                out[k] = match[k];
+        }
+        out += length;
+    }
+    return out == outEnd;
+}
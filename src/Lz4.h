@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+
+/* LZ4 block format (no frame header), compatible with LZ4_compress_default and
+   LZ4_decompress_safe. The compressor is a single-probe greedy matcher: it
+   packs a little worse than the reference one but decompression, the part
+   done at load time, runs at memory speed either way. */
+class Lz4
+{
+public:
+	/* Largest possible compressed size of [size] bytes */
+	static size_t CompressBound(size_t size);
+
+	/* Returns the compressed size, 0 if it doesn't fit into [capacity] */
+	static size_t Compress(const char* source, size_t size, char* destination, size_t capacity);
+
+	/* Decompresses exactly [size] bytes; false on malformed or truncated input */
+	static bool Decompress(const char* source, size_t sourceSize, char* destination, size_t size);
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/* A whole file mapped read-only into memory (mmap, MapViewOfFile on Windows).
+   Pages are read on first touch, so opening is cheap however big the file */
+class MappedFile
+{
+private:
+	const char* m_Data;
+	size_t m_Size;
+	void* m_File;		// Windows file and mapping handles
+	void* m_Mapping;
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	/* False if the file can't be opened or is empty */
+	bool Open(const std::string& path);
+	void Close();
+
+	inline const char* GetData() const { return m_Data; }
+	inline size_t GetSize() const { return m_Size; }
+	inline bool IsOpen() const { return m_Data != nullptr; }
+};
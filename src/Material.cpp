@@ -0,0 +1,133 @@
+#include "Material.h"
+
+#include <cstring>
+#include <iostream>
+#include "Renderer.h"
+#include "Texture.h"
+
+const MaterialParameter* MaterialLayout::Find(const std::string& name) const
+{
+    for (const MaterialParameter& parameter : m_Parameters)
+    {
+        if (parameter.name == name)
+            return &parameter;
+    }
+    return nullptr;
+}
+
+/* Definition of Material */
+Material::Material(unsigned int id, Shader& shader, const MaterialLayout& layout,
+    const UniformBuffer& parameterBuffer, unsigned int bufferOffset)
+    : m_ID(id), m_Shader(shader), m_Layout(layout), m_Parameters(layout.GetSize(), 0),
+      m_ParameterBuffer(parameterBuffer), m_BufferOffset(bufferOffset), m_Dirty(true), m_ProgramID(0),
+      m_TransformResolved(false)
+{
+}
+
+void Material::SetParameter(const std::string& name, const void* data, unsigned int size)
+{
+    const MaterialParameter* parameter = m_Layout.Find(name);
+    if (!parameter)
+    {
+        std::cout << "Warning: material parameter ' " << name << " ' doesn't exist " << std::endl;
+        return;
+    }
+    ASSERT(parameter->size == size);
+
+    /* Only a real change marks the block for upload */
+    unsigned char* dst = &m_Parameters[parameter->offset];
+    if (std::memcmp(dst, data, size) == 0)
+        return;
+    std::memcpy(dst, data, size);
+    m_Dirty = true;
+}
+
+void Material::SetTexture(unsigned int slot, const Texture& texture, const std::string& sampler)
+{
+    for (TextureBinding& binding : m_Textures)
+    {
+        if (binding.slot == slot)
+        {
+            binding.texture = &texture;
+            binding.sampler = m_Shader.GetUniformHandle(sampler.c_str());
+            return;
+        }
+    }
+    m_Textures.push_back({ slot, &texture, m_Shader.GetUniformHandle(sampler.c_str()) });
+}
+
+void Material::Bind()
+{
+    /* The block binding is program state that only this material sets,
+       so it is assigned once per program instead of on every bind */
+    if (m_ProgramID != m_Shader.m_RendererID)
+    {
+        m_ProgramID = m_Shader.m_RendererID;
+        /* glUniformBlockBinding() connects the reflected [Material] block
+           to the binding point of the parameter buffer */
+        const UniformBlockInfo* block = m_Shader.FindUniformBlock(MATERIAL_BLOCK_NAME);
+        if (block)
+        {
+            ASSERT((int)m_Parameters.size() >= block->dataSize);
+            GLCall(glUniformBlockBinding(m_ProgramID, block->index, MATERIAL_BLOCK_BINDING));
+        }
+    }
+
+    /* Sampler slots are program state as well, but other materials on the
+       same shader may point them elsewhere; the shader's value shadow turns
+       an unchanged slot into a no-op */
+    for (const TextureBinding& binding : m_Textures)
+    {
+        m_Shader.SetUniform(binding.sampler, (int)binding.slot);
+        binding.texture->Bind(binding.slot);
+    }
+
+    if (!m_Parameters.empty())
+        m_ParameterBuffer.BindRange(MATERIAL_BLOCK_BINDING, m_BufferOffset, (unsigned int)m_Parameters.size());
+}
+
+UniformHandle Material::GetTransformUniform()
+{
+    /* handles stay valid across hot reloads, so one lookup lasts the material's lifetime */
+    if (!m_TransformResolved)
+    {
+        m_TransformUniform = m_Shader.GetUniformHandle("transformations");
+        m_TransformResolved = true;
+    }
+    return m_TransformUniform;
+}
+
+/* Definition of Material Library */
+MaterialLibrary::MaterialLibrary(unsigned int capacity /*= 64 * 1024*/)
+    : m_ParameterBuffer(capacity), m_Alignment(256), m_NextOffset(0)
+{
+    /* Every parameter block slice has to start at a multiple of this alignment */
+    int alignment = 0;
+    GLCall(glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment));
+    if (alignment > 0)
+        m_Alignment = (unsigned int)alignment;
+}
+
+Material& MaterialLibrary::Create(Shader& shader, const MaterialLayout& layout)
+{
+    unsigned int offset = (m_NextOffset + m_Alignment - 1) / m_Alignment * m_Alignment;
+    ASSERT(offset + layout.GetSize() <= m_ParameterBuffer.GetSize());
+    m_NextOffset = offset + layout.GetSize();
+
+    unsigned int id = (unsigned int)m_Materials.size();
+    m_Materials.emplace_back(new Material(id, shader, layout, m_ParameterBuffer, offset));
+    return *m_Materials.back();
+}
+
+void MaterialLibrary::Update()
+{
+    for (const std::unique_ptr<Material>& material : m_Materials)
+    {
+        if (!material->m_Dirty || material->m_Parameters.empty())
+            continue;
+        m_ParameterBuffer.SetData(material->m_BufferOffset, material->m_Parameters.data(),
+            (unsigned int)material->m_Parameters.size());
+        material->m_Dirty = false;
+    }
+    m_ParameterBuffer.Unbind();
+}
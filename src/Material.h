@@ -0,0 +1,129 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+#include "UniformBuffer.h"
+
+class Texture;
+
+/* Uniform block binding point every material parameter block is bound to;
+   shaders declare it as: layout(std140) uniform Material { ... }; */
+#define MATERIAL_BLOCK_NAME "Material"
+#define MATERIAL_BLOCK_BINDING 0
+
+struct MaterialParameter
+{
+	std::string name;
+	unsigned int offset;
+	unsigned int size;
+};
+
+/* std140 layout of a material parameter block, pushed in declaration order */
+class MaterialLayout
+{
+private:
+	std::vector<MaterialParameter> m_Parameters;
+	unsigned int m_Size;
+
+	void PushAligned(const std::string& name, unsigned int alignment, unsigned int size)
+	{
+		unsigned int offset = (m_Size + alignment - 1) & ~(alignment - 1);
+		m_Parameters.push_back({ name, offset, size });
+		m_Size = offset + size;
+	}
+public:
+	MaterialLayout()
+		: m_Size(0) {}
+
+	template<typename T>
+	void Push(const std::string& name);
+
+	const MaterialParameter* Find(const std::string& name) const;
+
+	inline const std::vector<MaterialParameter>& GetParameters() const { return m_Parameters; }
+	/* Size of the block, rounded up to a vec4 as std140 requires */
+	inline unsigned int GetSize() const { return (m_Size + 15) & ~15u; }
+};
+
+template<> inline void MaterialLayout::Push<float>(const std::string& name)     { PushAligned(name, 4, 4); }
+template<> inline void MaterialLayout::Push<int>(const std::string& name)       { PushAligned(name, 4, 4); }
+template<> inline void MaterialLayout::Push<glm::vec2>(const std::string& name) { PushAligned(name, 8, 8); }
+template<> inline void MaterialLayout::Push<glm::vec3>(const std::string& name) { PushAligned(name, 16, 12); }
+template<> inline void MaterialLayout::Push<glm::vec4>(const std::string& name) { PushAligned(name, 16, 16); }
+template<> inline void MaterialLayout::Push<glm::mat4>(const std::string& name) { PushAligned(name, 16, 64); }
+
+class Material
+{
+private:
+	struct TextureBinding
+	{
+		unsigned int slot;
+		const Texture* texture;
+		UniformHandle sampler;
+	};
+
+	unsigned int m_ID;
+	Shader& m_Shader;
+	MaterialLayout m_Layout;
+	std::vector<TextureBinding> m_Textures;
+
+	// CPU copy of the parameter block and its slice of the shared uniform buffer
+	std::vector<unsigned char> m_Parameters;
+	const UniformBuffer& m_ParameterBuffer;
+	unsigned int m_BufferOffset;
+	bool m_Dirty;
+	// program the block binding was last assigned to
+	unsigned int m_ProgramID;
+	// "transformations" uniform of the shader, looked up on first use
+	UniformHandle m_TransformUniform;
+	bool m_TransformResolved;
+
+	friend class MaterialLibrary;
+	Material(unsigned int id, Shader& shader, const MaterialLayout& layout,
+		const UniformBuffer& parameterBuffer, unsigned int bufferOffset);
+public:
+	Material(const Material&) = delete;
+	Material& operator=(const Material&) = delete;
+
+	/* Untyped Set(), for parameter values recorded as bytes; [size] must match the layout */
+	void SetParameter(const std::string& name, const void* data, unsigned int size);
+
+	template<typename T>
+	void Set(const std::string& name, const T& value) { SetParameter(name, &value, sizeof(T)); }
+
+	/* Binds [texture] to [slot] and points the [sampler] uniform at it */
+	void SetTexture(unsigned int slot, const Texture& texture, const std::string& sampler);
+
+	/* Binds textures and the parameter block slice; the program itself is bound by the pipeline */
+	void Bind();
+
+	/* Handle of the "transformations" uniform the renderer sets per draw */
+	UniformHandle GetTransformUniform();
+
+	inline unsigned int GetID() const { return m_ID; }
+	inline Shader& GetShader() const { return m_Shader; }
+	inline bool IsDirty() const { return m_Dirty; }
+};
+
+/* Owns all materials and the uniform buffer their parameter blocks live in */
+class MaterialLibrary
+{
+private:
+	UniformBuffer m_ParameterBuffer;
+	unsigned int m_Alignment;
+	unsigned int m_NextOffset;
+	std::vector<std::unique_ptr<Material>> m_Materials;
+public:
+	MaterialLibrary(unsigned int capacity = 64 * 1024);
+
+	Material& Create(Shader& shader, const MaterialLayout& layout);
+
+	/* Uploads the parameter blocks that changed since the last call */
+	void Update();
+
+	inline const UniformBuffer& GetParameterBuffer() const { return m_ParameterBuffer; }
+};
@@ -0,0 +1,591 @@
+#include "ObjLoader.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string_view>
+#include <unordered_map>
+#include "JobSystem.h"
+#include "MappedFile.h"
+
+/* Smallest piece of the file worth a job of its own */
+#define OBJ_MIN_CHUNK_SIZE (1u << 20)
+/* Chunks per worker, so a chunk full of faces doesn't hold up the others */
+#define OBJ_CHUNKS_PER_WORKER 4
+/* Welding is split by key hash into this many independent tables; a power
+   of two, and fixed so the output doesn't depend on the worker count */
+#define OBJ_WELD_SHARDS 16
+
+namespace {
+
+/* Indices of one face corner, -1 where the face has no such attribute */
+struct ObjCorner
+{
+    int position;
+    int texCoord;
+    int normal;
+    /* bit set per attribute whose index is relative to the chunk start, see ParseFace */
+    int relative;
+};
+
+inline uint64_t HashCorner(const ObjCorner& corner)
+{
+    uint64_t hash = (uint64_t)(uint32_t)corner.position * 0x9E3779B97F4A7C15ull;
+    hash ^= (uint64_t)(uint32_t)corner.texCoord * 0xC2B2AE3D27D4EB4Full;
+    hash ^= (uint64_t)(uint32_t)corner.normal * 0x165667B19E3779F9ull;
+    hash ^= hash >> 32;
+    hash *= 0xD6E8FEB86659FD93ull;
+    return hash ^ (hash >> 32);
+}
+
+inline unsigned int GetShard(uint64_t hash)
+{
+    return (unsigned int)(hash >> 60) & (OBJ_WELD_SHARDS - 1);
+}
+
+/* Open-addressing corner -> vertex table, several times faster than
+   std::unordered_map for the tens of millions of lookups of a big model */
+class WeldMap
+{
+private:
+    struct Slot
+    {
+        int position;   // -1 while the slot is empty
+        int texCoord;
+        int normal;
+        unsigned int vertex;
+    };
+    std::vector<Slot> m_Slots;
+    size_t m_Mask;
+    size_t m_Count;
+
+    void Grow()
+    {
+        std::vector<Slot> slots(m_Slots.size() * 2, Slot{ -1, -1, -1, 0 });
+        m_Mask = slots.size() - 1;
+        for (const Slot& slot : m_Slots)
+        {
+            if (slot.position < 0)
+                continue;
+            size_t i = HashCorner({ slot.position, slot.texCoord, slot.normal, 0 }) & m_Mask;
+            while (slots[i].position >= 0)
+                i = (i + 1) & m_Mask;
+            slots[i] = slot;
+        }
+        m_Slots.swap(slots);
+    }
+public:
+    WeldMap(size_t expected)
+        : m_Count(0)
+    {
+        size_t capacity = 16;
+        while (capacity < expected * 2)
+            capacity *= 2;
+        m_Slots.assign(capacity, Slot{ -1, -1, -1, 0 });
+        m_Mask = capacity - 1;
+    }
+
+    /* Vertex of [corner], or [vertex] after adding it; [added] tells which */
+    unsigned int Insert(const ObjCorner& corner, uint64_t hash, unsigned int vertex, bool& added)
+    {
+        if ((m_Count + 1) * 2 > m_Slots.size())
+            Grow();
+        size_t i = hash & m_Mask;
+        while (m_Slots[i].position >= 0)
+        {
+            const Slot& slot = m_Slots[i];
+            if (slot.position == corner.position && slot.texCoord == corner.texCoord && slot.normal == corner.normal)
+            {
+                added = false;
+                return slot.vertex;
+            }
+            i = (i + 1) & m_Mask;
+        }
+        m_Slots[i] = { corner.position, corner.texCoord, corner.normal, vertex };
+        m_Count++;
+        added = true;
+        return vertex;
+    }
+};
+
+struct ObjMaterialUse
+{
+    unsigned int offset;    // corner offset while parsing, index offset once welded
+    std::string name;
+};
+
+/* One line-aligned piece of the file and everything parsed from it */
+struct ObjChunk
+{
+    const char* begin;
+    const char* end;
+
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> texCoords;
+    std::vector<glm::vec3> normals;
+    std::vector<ObjCorner> corners;        // three per triangle
+    std::vector<ObjMaterialUse> materialUses;
+    std::vector<std::string> libraries;
+
+    std::vector<ObjCorner> unique;        // welded within the chunk
+    std::vector<uint64_t> uniqueHashes;
+    std::vector<unsigned int> uniqueVertices;    // final vertex of each unique corner
+    std::vector<unsigned int> indices;    // into unique
+    unsigned int positionBase = 0, texCoordBase = 0, normalBase = 0, indexBase = 0;
+};
+
+inline const char* SkipSpace(const char* p, const char* end)
+{
+    while (p < end && (*p == ' ' || *p == '\t'))
+        p++;
+    return p;
+}
+
+inline const char* ParseFloat(const char* p, const char* end, float& value)
+{
+    p = SkipSpace(p, end);
+    /* from_chars takes no leading plus */
+    if (p < end && *p == '+')
+        p++;
+    std::from_chars_result result = std::from_chars(p, end, value);
+    if (result.ec != std::errc())
+        value = 0.0f;
+    return result.ptr;
+}
+
+inline const char* ParseInt(const char* p, const char* end, int& value, bool& parsed)
+{
+    std::from_chars_result result = std::from_chars(p, end, value);
+    parsed = result.ec == std::errc();
+    return result.ptr;
+}
+
+/* Rest of the line without surrounding white space */
+inline std::string_view GetRest(const char* p, const char* end)
+{
+    p = SkipSpace(p, end);
+    while (end > p && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r'))
+        end--;
+    return std::string_view(p, (size_t)(end - p));
+}
+
+/* OBJ indices are 1-based, or negative counting back from the latest
+   element. The latest element is only known within the chunk here, so such
+   indices are stored relative to the chunk start and fixed up once the
+   element counts of the earlier chunks are known */
+inline int ResolveIndex(int index, size_t localCount, int bit, ObjCorner& corner)
+{
+    if (index > 0)
+        return index - 1;
+    corner.relative |= bit;
+    return (int)localCount + index;
+}
+
+void ParseFace(const char* p, const char* end, ObjChunk& chunk, std::vector<ObjCorner>& face)
+{
+    face.clear();
+    while (true)
+    {
+        p = SkipSpace(p, end);
+        if (p >= end || *p == '\r' || *p == '#')
+            break;
+
+        ObjCorner corner = { -1, -1, -1, 0 };
+        int index = 0;
+        bool parsed = false;
+        p = ParseInt(p, end, index, parsed);
+        if (!parsed || index == 0)
+            return;
+        corner.position = ResolveIndex(index, chunk.positions.size(), 1, corner);
+        if (p < end && *p == '/')
+        {
+            p++;
+            if (p < end && *p != '/')
+            {
+                p = ParseInt(p, end, index, parsed);
+                if (parsed && index != 0)
+                    corner.texCoord = ResolveIndex(index, chunk.texCoords.size(), 2, corner);
+            }
+            if (p < end && *p == '/')
+            {
+                p = ParseInt(p + 1, end, index, parsed);
+                if (parsed && index != 0)
+                    corner.normal = ResolveIndex(index, chunk.normals.size(), 4, corner);
+            }
+        }
+        face.push_back(corner);
+        /* skip whatever is left of a malformed corner */
+        while (p < end && *p != ' ' && *p != '\t' && *p != '\r')
+            p++;
+    }
+
+    for (size_t i = 2; i < face.size(); i++)
+    {
+        chunk.corners.push_back(face[0]);
+        chunk.corners.push_back(face[i - 1]);
+        chunk.corners.push_back(face[i]);
+    }
+}
+
+void ParseChunk(ObjChunk& chunk)
+{
+    std::vector<ObjCorner> face;
+    const char* p = chunk.begin;
+    while (p < chunk.end)
+    {
+        const char* lineEnd = (const char*)std::memchr(p, '\n', (size_t)(chunk.end - p));
+        if (!lineEnd)
+            lineEnd = chunk.end;
+        const char* line = SkipSpace(p, lineEnd);
+        p = lineEnd + 1;
+        if (lineEnd - line < 2)
+            continue;
+
+        if (line[0] == 'v')
+        {
+            if (line[1] == ' ' || line[1] == '\t')
+            {
+                glm::vec3 position;
+                const char* q = ParseFloat(line + 1, lineEnd, position.x);
+                q = ParseFloat(q, lineEnd, position.y);
+                ParseFloat(q, lineEnd, position.z);
+                chunk.positions.push_back(position);
+            }
+            else if (line[1] == 't')
+            {
+                glm::vec2 texCoord;
+                const char* q = ParseFloat(line + 2, lineEnd, texCoord.x);
+                ParseFloat(q, lineEnd, texCoord.y);
+                chunk.texCoords.push_back(texCoord);
+            }
+            else if (line[1] == 'n')
+            {
+                glm::vec3 normal;
+                const char* q = ParseFloat(line + 2, lineEnd, normal.x);
+                q = ParseFloat(q, lineEnd, normal.y);
+                ParseFloat(q, lineEnd, normal.z);
+                chunk.normals.push_back(normal);
+            }
+        }
+        else if (line[0] == 'f' && (line[1] == ' ' || line[1] == '\t'))
+            ParseFace(line + 1, lineEnd, chunk, face);
+        else if (lineEnd - line > 7 && std::memcmp(line, "usemtl", 6) == 0)
+            chunk.materialUses.push_back({ (unsigned int)chunk.corners.size(), std::string(GetRest(line + 6, lineEnd)) });
+        else if (lineEnd - line > 7 && std::memcmp(line, "mtllib", 6) == 0)
+            chunk.libraries.emplace_back(GetRest(line + 6, lineEnd));
+    }
+}
+
+/* Fixes up relative indices, welds the chunk's corners and turns the
+   material uses into index offsets; triangles with a bad index are dropped */
+void WeldChunk(ObjChunk& chunk, unsigned int positionCount, unsigned int texCoordCount, unsigned int normalCount)
+{
+    /* closed meshes share each vertex between about six triangles */
+    WeldMap map(chunk.corners.size() / 8);
+    chunk.indices.reserve(chunk.corners.size());
+    size_t use = 0;
+    for (size_t t = 0; t < chunk.corners.size(); t += 3)
+    {
+        for (; use < chunk.materialUses.size() && chunk.materialUses[use].offset <= t; use++)
+            chunk.materialUses[use].offset = (unsigned int)chunk.indices.size();
+
+        ObjCorner* corners = &chunk.corners[t];
+        bool valid = true;
+        for (int k = 0; k < 3; k++)
+        {
+            ObjCorner& corner = corners[k];
+            if (corner.relative)
+            {
+                if (corner.relative & 1)
+                    corner.position += (int)chunk.positionBase;
+                if (corner.relative & 2)
+                    corner.texCoord += (int)chunk.texCoordBase;
+                if (corner.relative & 4)
+                    corner.normal += (int)chunk.normalBase;
+                corner.relative = 0;
+            }
+            valid &= corner.position >= 0 && (unsigned int)corner.position < positionCount;
+            valid &= corner.texCoord < 0 || (unsigned int)corner.texCoord < texCoordCount;
+            valid &= corner.normal < 0 || (unsigned int)corner.normal < normalCount;
+        }
+        if (!valid)
+            continue;
+
+        for (int k = 0; k < 3; k++)
+        {
+            uint64_t hash = HashCorner(corners[k]);
+            bool added;
+            unsigned int vertex = map.Insert(corners[k], hash, (unsigned int)chunk.unique.size(), added);
+            if (added)
+            {
+                chunk.unique.push_back(corners[k]);
+                chunk.uniqueHashes.push_back(hash);
+            }
+            chunk.indices.push_back(vertex);
+        }
+    }
+    for (; use < chunk.materialUses.size(); use++)
+        chunk.materialUses[use].offset = (unsigned int)chunk.indices.size();
+
+    std::vector<ObjCorner>().swap(chunk.corners);
+    chunk.uniqueVertices.resize(chunk.unique.size());
+}
+
+void ParallelFor(JobSystem* jobs, unsigned int count, const std::function<void(unsigned int, unsigned int)>& function)
+{
+    if (jobs)
+        jobs->ParallelFor(count, 1, function);
+    else
+        function(0, count);
+}
+
+}
+
+bool ObjLoader::Load(const std::string& filepath, MeshData& mesh, JobSystem* jobs /*= nullptr*/)
+{
+    MappedFile file;
+    if (!file.Open(filepath))
+    {
+        std::cout << "Warning: model ' " << filepath << " ' couldn't be opened " << std::endl;
+        return false;
+    }
+    const char* data = file.GetData();
+    const size_t size = file.GetSize();
+
+    /* cut at line ends near equal offsets */
+    size_t chunkCount = 1;
+    if (jobs)
+        chunkCount = std::max<size_t>(1, std::min<size_t>(size / OBJ_MIN_CHUNK_SIZE, jobs->GetWorkerCount() * OBJ_CHUNKS_PER_WORKER));
+    std::vector<ObjChunk> chunks(chunkCount);
+    const char* begin = data;
+    for (size_t i = 0; i < chunkCount; i++)
+    {
+        const char* end = data + size * (i + 1) / chunkCount;
+        if (i + 1 < chunkCount)
+        {
+            const char* newline = (const char*)std::memchr(end, '\n', (size_t)(data + size - end));
+            end = newline ? newline + 1 : data + size;
+        }
+        end = std::max(begin, end);
+        chunks[i].begin = begin;
+        chunks[i].end = end;
+        begin = end;
+    }
+
+    ParallelFor(jobs, (unsigned int)chunkCount, [&](unsigned int first, unsigned int last)
+    {
+        for (unsigned int i = first; i < last; i++)
+            ParseChunk(chunks[i]);
+    });
+
+    /* element counts of the earlier chunks give each chunk its base */
+    unsigned int positionCount = 0, texCoordCount = 0, normalCount = 0;
+    for (ObjChunk& chunk : chunks)
+    {
+        chunk.positionBase = positionCount;
+        chunk.texCoordBase = texCoordCount;
+        chunk.normalBase = normalCount;
+        positionCount += (unsigned int)chunk.positions.size();
+        texCoordCount += (unsigned int)chunk.texCoords.size();
+        normalCount += (unsigned int)chunk.normals.size();
+    }
+    std::vector<glm::vec3> positions(positionCount);
+    std::vector<glm::vec2> texCoords(texCoordCount);
+    std::vector<glm::vec3> normals(normalCount);
+
+    ParallelFor(jobs, (unsigned int)chunkCount, [&](unsigned int first, unsigned int last)
+    {
+        for (unsigned int i = first; i < last; i++)
+        {
+            ObjChunk& chunk = chunks[i];
+            std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + chunk.positionBase);
+            std::copy(chunk.texCoords.begin(), chunk.texCoords.end(), texCoords.begin() + chunk.texCoordBase);
+            std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + chunk.normalBase);
+            std::vector<glm::vec3>().swap(chunk.positions);
+            std::vector<glm::vec2>().swap(chunk.texCoords);
+            std::vector<glm::vec3>().swap(chunk.normals);
+            WeldChunk(chunk, positionCount, texCoordCount, normalCount);
+        }
+    });
+
+    /* weld across chunks: every shard owns the corners whose hash falls into it */
+    size_t uniqueCount = 0;
+    for (const ObjChunk& chunk : chunks)
+        uniqueCount += chunk.unique.size();
+    std::vector<std::vector<ObjCorner>> shardCorners(OBJ_WELD_SHARDS);
+    ParallelFor(jobs, OBJ_WELD_SHARDS, [&](unsigned int first, unsigned int last)
+    {
+        for (unsigned int shard = first; shard < last; shard++)
+        {
+            WeldMap map(uniqueCount / OBJ_WELD_SHARDS);
+            std::vector<ObjCorner>& corners = shardCorners[shard];
+            for (ObjChunk& chunk : chunks)
+            {
+                for (size_t u = 0; u < chunk.unique.size(); u++)
+                {
+                    if (GetShard(chunk.uniqueHashes[u]) != shard)
+                        continue;
+                    bool added;
+                    chunk.uniqueVertices[u] = map.Insert(chunk.unique[u], chunk.uniqueHashes[u], (unsigned int)corners.size(), added);
+                    if (added)
+                        corners.push_back(chunk.unique[u]);
+                }
+            }
+        }
+    });
+
+    unsigned int shardBase[OBJ_WELD_SHARDS];
+    unsigned int vertexCount = 0;
+    for (unsigned int shard = 0; shard < OBJ_WELD_SHARDS; shard++)
+    {
+        shardBase[shard] = vertexCount;
+        vertexCount += (unsigned int)shardCorners[shard].size();
+    }
+    unsigned int indexCount = 0;
+    for (ObjChunk& chunk : chunks)
+    {
+        chunk.indexBase = indexCount;
+        indexCount += (unsigned int)chunk.indices.size();
+    }
+
+    mesh.vertices.resize(vertexCount);
+    mesh.indices.resize(indexCount);
+    ParallelFor(jobs, (unsigned int)chunkCount, [&](unsigned int first, unsigned int last)
+    {
+        for (unsigned int i = first; i < last; i++)
+        {
+            ObjChunk& chunk = chunks[i];
+            for (size_t u = 0; u < chunk.unique.size(); u++)
+                chunk.uniqueVertices[u] += shardBase[GetShard(chunk.uniqueHashes[u])];
+            for (size_t k = 0; k < chunk.indices.size(); k++)
+                mesh.indices[chunk.indexBase + k] = chunk.uniqueVertices[chunk.indices[k]];
+        }
+    });
+    ParallelFor(jobs, OBJ_WELD_SHARDS, [&](unsigned int first, unsigned int last)
+    {
+        for (unsigned int shard = first; shard < last; shard++)
+        {
+            const std::vector<ObjCorner>& corners = shardCorners[shard];
+            for (size_t j = 0; j < corners.size(); j++)
+            {
+                MeshVertex& vertex = mesh.vertices[shardBase[shard] + j];
+                vertex.position = positions[corners[j].position];
+                vertex.texCoord = corners[j].texCoord >= 0 ? texCoords[corners[j].texCoord] : glm::vec2(0.0f);
+                vertex.normal = corners[j].normal >= 0 ? normals[corners[j].normal] : glm::vec3(0.0f);
+            }
+        }
+    });
+
+    /* materials, resolved against the libraries the file names */
+    mesh.materials.clear();
+    std::filesystem::path directory = std::filesystem::path(filepath).parent_path();
+    std::vector<std::string> libraries;
+    for (const ObjChunk& chunk : chunks)
+    {
+        for (const std::string& library : chunk.libraries)
+        {
+            if (std::find(libraries.begin(), libraries.end(), library) == libraries.end())
+                libraries.push_back(library);
+        }
+    }
+    for (const std::string& library : libraries)
+        LoadMaterials((directory / library).generic_string(), mesh.materials);
+    std::unordered_map<std::string, int> materialIndices;
+    for (size_t i = 0; i < mesh.materials.size(); i++)
+        materialIndices.emplace(mesh.materials[i].name, (int)i);
+
+    mesh.parts.clear();
+    MeshPart part = { 0, 0, -1 };
+    for (const ObjChunk& chunk : chunks)
+    {
+        for (const ObjMaterialUse& use : chunk.materialUses)
+        {
+            unsigned int offset = chunk.indexBase + use.offset;
+            auto it = materialIndices.find(use.name);
+            int material = it != materialIndices.end() ? it->second : -1;
+            if (offset > part.firstIndex)
+            {
+                part.indexCount = offset - part.firstIndex;
+                mesh.parts.push_back(part);
+            }
+            part = { offset, 0, material };
+        }
+    }
+    if (indexCount > part.firstIndex)
+    {
+        part.indexCount = indexCount - part.firstIndex;
+        mesh.parts.push_back(part);
+    }
+    return true;
+}
+
+bool ObjLoader::LoadMaterials(const std::string& filepath, std::vector<MeshMaterial>& materials)
+{
+    MappedFile file;
+    if (!file.Open(filepath))
+    {
+        std::cout << "Warning: material library ' " << filepath << " ' couldn't be opened " << std::endl;
+        return false;
+    }
+    std::filesystem::path directory = std::filesystem::path(filepath).parent_path();
+    /* texture options such as "-bm 0.5" come first, the path is the last token */
+    auto texturePath = [&directory](std::string_view rest)
+    {
+        size_t space = rest.find_last_of(" \t");
+        std::string_view name = space == std::string_view::npos ? rest : rest.substr(space + 1);
+        return (directory / std::string(name)).generic_string();
+    };
+
+    MeshMaterial* material = nullptr;
+    const char* p = file.GetData();
+    const char* end = p + file.GetSize();
+    while (p < end)
+    {
+        const char* lineEnd = (const char*)std::memchr(p, '\n', (size_t)(end - p));
+        if (!lineEnd)
+            lineEnd = end;
+        const char* line = SkipSpace(p, lineEnd);
+        p = lineEnd + 1;
+
+        const char* keyEnd = line;
+        while (keyEnd < lineEnd && *keyEnd != ' ' && *keyEnd != '\t' && *keyEnd != '\r')
+            keyEnd++;
+        std::string_view key(line, (size_t)(keyEnd - line));
+        if (key == "newmtl")
+        {
+            materials.emplace_back();
+            material = &materials.back();
+            material->name = std::string(GetRest(keyEnd, lineEnd));
+            continue;
+        }
+        if (!material)
+            continue;
+
+        if (key == "Ka" || key == "Kd" || key == "Ks")
+        {
+            glm::vec3 color;
+            const char* q = ParseFloat(keyEnd, lineEnd, color.r);
+            q = ParseFloat(q, lineEnd, color.g);
+            ParseFloat(q, lineEnd, color.b);
+            (key == "Ka" ? material->ambient : key == "Kd" ? material->diffuse : material->specular) = color;
+        }
+        else if (key == "Ns")
+            ParseFloat(keyEnd, lineEnd, material->shininess);
+        else if (key == "d")
+            ParseFloat(keyEnd, lineEnd, material->opacity);
+        else if (key == "Tr")
+        {
+            float transparency = 0.0f;
+            ParseFloat(keyEnd, lineEnd, transparency);
+            material->opacity = 1.0f - transparency;
+        }
+        else if (key == "map_Kd")
+            material->diffuseTexture = texturePath(GetRest(keyEnd, lineEnd));
+        else if (key == "map_Bump" || key == "map_bump" || key == "bump" || key == "norm")
+            material->normalTexture = texturePath(GetRest(keyEnd, lineEnd));
+    }
+    return true;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class JobSystem;
+
+/* Interleaved vertex of a loaded mesh; as a VertexBufferLayout:
+   Push<float>(3) position, Push<float>(2) texture coordinate, Push<float>(3) normal */
+struct MeshVertex
+{
+	glm::vec3 position;
+	glm::vec2 texCoord;
+	glm::vec3 normal;
+};
+
+/* The parts of an MTL material the renderer can use; texture paths are
+   relative to the working directory like every other asset path */
+struct MeshMaterial
+{
+	std::string name;
+	glm::vec3 ambient = glm::vec3(0.0f);
+	glm::vec3 diffuse = glm::vec3(1.0f);
+	glm::vec3 specular = glm::vec3(0.0f);
+	float shininess = 0.0f;
+	float opacity = 1.0f;
+	std::string diffuseTexture;
+	std::string normalTexture;
+};
+
+/* A run of triangles drawn with one material, -1 when the file named none */
+struct MeshPart
+{
+	unsigned int firstIndex;
+	unsigned int indexCount;
+	int material;
+};
+
+/* Indexed triangle mesh, ready for VertexBuffer(vertices.data(), vertices.size() * sizeof(MeshVertex))
+   and IndexBuffer(indices.data(), indices.size()) */
+struct MeshData
+{
+	std::vector<MeshVertex> vertices;
+	std::vector<unsigned int> indices;
+	std::vector<MeshPart> parts;
+	std::vector<MeshMaterial> materials;
+};
+
+/* Wavefront OBJ/MTL importer.
+   The file is memory-mapped and cut into line-aligned chunks that are
+   parsed in parallel with std::from_chars. Corners with the same position,
+   texture coordinate and normal are welded into one vertex, polygons are
+   triangulated as fans. Only polygonal geometry is read: v, vt, vn, f,
+   usemtl and mtllib; lines, curves and groups are skipped. */
+class ObjLoader
+{
+public:
+	/* False if the file can't be read; malformed lines are skipped */
+	static bool Load(const std::string& filepath, MeshData& mesh, JobSystem* jobs = nullptr);
+	/* Appends the materials of an MTL file to [materials] */
+	static bool LoadMaterials(const std::string& filepath, std::vector<MeshMaterial>& materials);
+};
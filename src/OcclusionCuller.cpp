@@ -0,0 +1,277 @@
+#include "OcclusionCuller.h"
+
+#include <algorithm>
+#include <cmath>
+#include "JobSystem.h"
+#include "Simd.h"
+
+#define OCCLUSION_TILES_X (OCCLUSION_WIDTH / OCCLUSION_TILE_WIDTH)
+#define OCCLUSION_TILES_Y (OCCLUSION_HEIGHT / OCCLUSION_TILE_HEIGHT)
+/* Vertices with a smaller clip w are at or behind the eye */
+#define OCCLUSION_MIN_W 1e-5f
+/* An occluder has to be this much nearer than a box to hide it, so an object
+   drawn as its own occluder isn't hidden by rounding of its transforms */
+#define OCCLUSION_DEPTH_BIAS 1e-5f
+
+static_assert(OCCLUSION_WIDTH % OCCLUSION_TILE_WIDTH == 0 && OCCLUSION_HEIGHT % OCCLUSION_TILE_HEIGHT == 0,
+    "the depth buffer has to be made of whole tiles");
+static_assert(OCCLUSION_TILE_WIDTH % 4 == 0, "tile rows are rasterized 4 pixels at a time");
+
+/* Corners of a box as (x, y, z) picks of min (0) and max (1) */
+static const int s_BoxCorners[8][3] = {
+    { 0, 0, 0 }, { 1, 0, 0 }, { 1, 1, 0 }, { 0, 1, 0 },
+    { 0, 0, 1 }, { 1, 0, 1 }, { 1, 1, 1 }, { 0, 1, 1 }
+};
+
+static const unsigned int s_BoxIndices[36] = {
+    0, 2, 1, 0, 3, 2,   // -z
+    4, 5, 6, 4, 6, 7,   // +z
+    0, 1, 5, 0, 5, 4,   // -y
+    3, 6, 2, 3, 7, 6,   // +y
+    0, 4, 7, 0, 7, 3,   // -x
+    1, 2, 6, 1, 6, 5    // +x
+};
+
+static inline glm::vec3 GetCorner(const AABB& box, int corner)
+{
+    return glm::vec3(s_BoxCorners[corner][0] ? box.max.x : box.min.x,
+                     s_BoxCorners[corner][1] ? box.max.y : box.min.y,
+                     s_BoxCorners[corner][2] ? box.max.z : box.min.z);
+}
+
+/* Clip space to (pixel x, pixel y, depth in [0, 1]) */
+static inline glm::vec3 ToScreen(const glm::vec4& clip)
+{
+    float inverseW = 1.0f / clip.w;
+    return glm::vec3((clip.x * inverseW * 0.5f + 0.5f) * OCCLUSION_WIDTH,
+                     (clip.y * inverseW * 0.5f + 0.5f) * OCCLUSION_HEIGHT,
+                     clip.z * inverseW * 0.5f + 0.5f);
+}
+
+OcclusionCuller::OcclusionCuller()
+    : m_Depth(OCCLUSION_WIDTH * OCCLUSION_HEIGHT, 1.0f), m_Bins(OCCLUSION_TILES_X * OCCLUSION_TILES_Y), m_Rejected(0)
+{
+}
+
+void OcclusionCuller::Begin()
+{
+    std::fill(m_Depth.begin(), m_Depth.end(), 1.0f);
+    m_Triangles.clear();
+    for (std::vector<unsigned int>& bin : m_Bins)
+        bin.clear();
+    m_Rejected = 0;
+}
+
+void OcclusionCuller::AddTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c)
+{
+    /* there is no near plane clipping: a triangle reaching behind the eye is
+       dropped, which only ever makes the culling more conservative */
+    if (a.w < OCCLUSION_MIN_W || b.w < OCCLUSION_MIN_W || c.w < OCCLUSION_MIN_W)
+    {
+        m_Rejected++;
+        return;
+    }
+
+    Triangle triangle = { { ToScreen(a), ToScreen(b), ToScreen(c) } };
+    glm::vec3& v0 = triangle.v[0];
+    glm::vec3& v1 = triangle.v[1];
+    glm::vec3& v2 = triangle.v[2];
+
+    /* both windings occlude, the rasterizer expects a positive area */
+    float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+    if (area == 0.0f)
+        return;
+    if (area < 0.0f)
+        std::swap(v1, v2);
+
+    float minX = std::min(std::min(v0.x, v1.x), v2.x), maxX = std::max(std::max(v0.x, v1.x), v2.x);
+    float minY = std::min(std::min(v0.y, v1.y), v2.y), maxY = std::max(std::max(v0.y, v1.y), v2.y);
+    if (maxX < 0.0f || maxY < 0.0f || minX >= OCCLUSION_WIDTH || minY >= OCCLUSION_HEIGHT)
+        return;
+
+    int firstTileX = std::max(0, (int)minX / OCCLUSION_TILE_WIDTH);
+    int lastTileX = std::min(OCCLUSION_TILES_X - 1, (int)maxX / OCCLUSION_TILE_WIDTH);
+    int firstTileY = std::max(0, (int)minY / OCCLUSION_TILE_HEIGHT);
+    int lastTileY = std::min(OCCLUSION_TILES_Y - 1, (int)maxY / OCCLUSION_TILE_HEIGHT);
+
+    unsigned int index = (unsigned int)m_Triangles.size();
+    m_Triangles.push_back(triangle);
+    for (int ty = firstTileY; ty <= lastTileY; ty++)
+    {
+        for (int tx = firstTileX; tx <= lastTileX; tx++)
+            m_Bins[ty * OCCLUSION_TILES_X + tx].push_back(index);
+    }
+}
+
+void OcclusionCuller::AddOccluder(const glm::vec3* vertices, const unsigned int* indices, unsigned int indexCount, const glm::mat4& mvp)
+{
+    for (unsigned int i = 0; i + 2 < indexCount; i += 3)
+    {
+        AddTriangle(mvp * glm::vec4(vertices[indices[i]], 1.0f),
+                    mvp * glm::vec4(vertices[indices[i + 1]], 1.0f),
+                    mvp * glm::vec4(vertices[indices[i + 2]], 1.0f));
+    }
+}
+
+void OcclusionCuller::AddOccluder(const AABB& box, const glm::mat4& mvp)
+{
+    glm::vec4 corners[8];
+    for (int i = 0; i < 8; i++)
+        corners[i] = mvp * glm::vec4(GetCorner(box, i), 1.0f);
+    for (int i = 0; i < 36; i += 3)
+        AddTriangle(corners[s_BoxIndices[i]], corners[s_BoxIndices[i + 1]], corners[s_BoxIndices[i + 2]]);
+}
+
+void OcclusionCuller::RasterizeTile(unsigned int tile)
+{
+    const int tileX = (int)(tile % OCCLUSION_TILES_X) * OCCLUSION_TILE_WIDTH;
+    const int tileY = (int)(tile / OCCLUSION_TILES_X) * OCCLUSION_TILE_HEIGHT;
+
+    for (unsigned int index : m_Bins[tile])
+    {
+        const Triangle& triangle = m_Triangles[index];
+        const glm::vec3& v0 = triangle.v[0];
+        const glm::vec3& v1 = triangle.v[1];
+        const glm::vec3& v2 = triangle.v[2];
+
+        /* edge functions E(x, y) = A x + B y + C, all >= 0 inside;
+           edge i is the one opposite vertex i */
+        const glm::vec3* p[3] = { &v1, &v2, &v0 };
+        const glm::vec3* q[3] = { &v2, &v0, &v1 };
+        float A[3], B[3], C[3];
+        for (int e = 0; e < 3; e++)
+        {
+            A[e] = p[e]->y - q[e]->y;
+            B[e] = q[e]->x - p[e]->x;
+            C[e] = -A[e] * p[e]->x - B[e] * p[e]->y;
+        }
+
+        /* depth is affine in screen space, weighted by the normalized edge functions */
+        float area = A[2] * v2.x + B[2] * v2.y + C[2];
+        float inverseArea = 1.0f / area;
+        float zA = (v0.z * A[0] + v1.z * A[1] + v2.z * A[2]) * inverseArea;
+        float zB = (v0.z * B[0] + v1.z * B[1] + v2.z * B[2]) * inverseArea;
+        float zC = (v0.z * C[0] + v1.z * C[1] + v2.z * C[2]) * inverseArea;
+        /* inside the triangle the depth can't be nearer than its nearest vertex,
+           the plane equation only gets there by rounding */
+        float nearest = std::min(std::min(v0.z, v1.z), v2.z);
+
+        /* bounds of the triangle inside the tile, x rounded to groups of 4 */
+        int minX = std::max(tileX, (int)std::floor(std::min(std::min(v0.x, v1.x), v2.x)) & ~3);
+        int maxX = std::min(tileX + OCCLUSION_TILE_WIDTH - 1, (int)std::ceil(std::max(std::max(v0.x, v1.x), v2.x)));
+        int minY = std::max(tileY, (int)std::floor(std::min(std::min(v0.y, v1.y), v2.y)));
+        int maxY = std::min(tileY + OCCLUSION_TILE_HEIGHT - 1, (int)std::ceil(std::max(std::max(v0.y, v1.y), v2.y)));
+
+        for (int y = minY; y <= maxY; y++)
+        {
+            float py = (float)y + 0.5f;
+            float* row = &m_Depth[y * OCCLUSION_WIDTH];
+            int x = minX;
+#if defined(SIMD_SSE2) || defined(SIMD_AVX2)
+            __m128 rowE0 = _mm_set1_ps(B[0] * py + C[0]);
+            __m128 rowE1 = _mm_set1_ps(B[1] * py + C[1]);
+            __m128 rowE2 = _mm_set1_ps(B[2] * py + C[2]);
+            __m128 rowZ = _mm_set1_ps(zB * py + zC);
+            __m128 a0 = _mm_set1_ps(A[0]), a1 = _mm_set1_ps(A[1]), a2 = _mm_set1_ps(A[2]), az = _mm_set1_ps(zA);
+            __m128 nearestZ = _mm_set1_ps(nearest);
+            __m128 zero = _mm_setzero_ps();
+            /* [minX] and the tile edges are multiples of 4, so a group never leaves the tile */
+            for (; x <= maxX; x += 4)
+            {
+                __m128 px = _mm_add_ps(_mm_set1_ps((float)x), _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f));
+                __m128 e0 = _mm_add_ps(_mm_mul_ps(a0, px), rowE0);
+                __m128 e1 = _mm_add_ps(_mm_mul_ps(a1, px), rowE1);
+                __m128 e2 = _mm_add_ps(_mm_mul_ps(a2, px), rowE2);
+                __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+                if (_mm_movemask_ps(inside) == 0)
+                    continue;
+                __m128 z = _mm_max_ps(_mm_add_ps(_mm_mul_ps(az, px), rowZ), nearestZ);
+                __m128 depth = _mm_loadu_ps(row + x);
+                __m128 nearer = _mm_min_ps(depth, z);
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, depth)));
+            }
+#endif
+            for (; x <= maxX; x++)
+            {
+                float px = (float)x + 0.5f;
+                if (A[0] * px + B[0] * py + C[0] < 0.0f || A[1] * px + B[1] * py + C[1] < 0.0f || A[2] * px + B[2] * py + C[2] < 0.0f)
+                    continue;
+                row[x] = std::min(row[x], std::max(zA * px + zB * py + zC, nearest));
+            }
+        }
+    }
+}
+
+void OcclusionCuller::Rasterize(JobSystem* jobs /*= nullptr*/)
+{
+    const unsigned int tileCount = OCCLUSION_TILES_X * OCCLUSION_TILES_Y;
+    auto rasterize = [this](unsigned int begin, unsigned int end)
+    {
+        for (unsigned int tile = begin; tile < end; tile++)
+        {
+            if (!m_Bins[tile].empty())
+                RasterizeTile(tile);
+        }
+    };
+
+    /* tiles own disjoint pixels, so they need no synchronization */
+    if (jobs)
+        jobs->ParallelFor(tileCount, 1, rasterize);
+    else
+        rasterize(0, tileCount);
+}
+
+bool OcclusionCuller::IsVisible(const AABB& worldBox, const glm::mat4& viewProjection) const
+{
+    float minX = (float)OCCLUSION_WIDTH, maxX = 0.0f, minY = (float)OCCLUSION_HEIGHT, maxY = 0.0f, minZ = 1.0f;
+    for (int i = 0; i < 8; i++)
+    {
+        glm::vec4 clip = viewProjection * glm::vec4(GetCorner(worldBox, i), 1.0f);
+        /* a box reaching behind the eye can't be bounded on screen */
+        if (clip.w < OCCLUSION_MIN_W)
+            return true;
+        glm::vec3 screen = ToScreen(clip);
+        minX = std::min(minX, screen.x); maxX = std::max(maxX, screen.x);
+        minY = std::min(minY, screen.y); maxY = std::max(maxY, screen.y);
+        minZ = std::min(minZ, screen.z);
+    }
+
+    int x0 = std::max(0, (int)std::floor(minX)), x1 = std::min(OCCLUSION_WIDTH - 1, (int)std::floor(maxX));
+    int y0 = std::max(0, (int)std::floor(minY)), y1 = std::min(OCCLUSION_HEIGHT - 1, (int)std::floor(maxY));
+    /* off screen boxes are left to the frustum culling */
+    if (x0 > x1 || y0 > y1)
+        return true;
+
+    /* visible as soon as one covered pixel has no occluder in front of the box */
+    minZ -= OCCLUSION_DEPTH_BIAS;
+    for (int y = y0; y <= y1; y++)
+    {
+        const float* row = &m_Depth[y * OCCLUSION_WIDTH];
+        int x = x0;
+#if defined(SIMD_SSE2) || defined(SIMD_AVX2)
+        __m128 boxDepth = _mm_set1_ps(minZ);
+        for (; x + 3 <= x1; x += 4)
+        {
+            if (_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(row + x), boxDepth)))
+                return true;
+        }
+#endif
+        for (; x <= x1; x++)
+        {
+            if (row[x] >= minZ)
+                return true;
+        }
+    }
+    return false;
+}
+
+void OcclusionCuller::Cull(const AABBArray& worldBoxes, const glm::mat4& viewProjection, std::vector<unsigned int>& visible) const
+{
+    unsigned int kept = 0;
+    for (unsigned int object : visible)
+    {
+        if (IsVisible(worldBoxes.Get(object), viewProjection))
+            visible[kept++] = object;
+    }
+    visible.resize(kept);
+}
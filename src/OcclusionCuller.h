@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Bounds.h"
+
+class JobSystem;
+
+/* Size of the CPU depth buffer, a multiple of the tile size */
+#define OCCLUSION_WIDTH 256
+#define OCCLUSION_HEIGHT 128
+#define OCCLUSION_TILE_WIDTH 64
+#define OCCLUSION_TILE_HEIGHT 32
+
+/* Software occlusion culling.
+   Occluders (walls, big solid meshes) are rasterized into a small depth
+   buffer on the CPU, then the screen rectangle of each occludee's bounds
+   is compared against it: if every covered pixel holds an occluder nearer
+   than the nearest point of the box, the object is hidden. Nothing is read
+   back from the GPU. The buffer is split into tiles that are rasterized in
+   parallel, each tile only walks the triangles binned to it. */
+class OcclusionCuller
+{
+private:
+	struct Triangle
+	{
+		glm::vec3 v[3];	// pixel x, pixel y, depth in [0, 1]
+	};
+
+	std::vector<float> m_Depth;		// nearest occluder depth per pixel, row major
+	std::vector<Triangle> m_Triangles;
+	std::vector<std::vector<unsigned int>> m_Bins;	// triangles overlapping each tile
+	unsigned int m_Rejected;	// triangles crossing the near plane, skipped
+
+	void AddTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+	void RasterizeTile(unsigned int tile);
+public:
+	OcclusionCuller();
+
+	/* Clears the depth buffer and the occluders of the last frame */
+	void Begin();
+
+	/* Adds the triangles of an indexed mesh; [mvp] takes [vertices] to clip space */
+	void AddOccluder(const glm::vec3* vertices, const unsigned int* indices, unsigned int indexCount, const glm::mat4& mvp);
+	/* Adds a solid box, [box] is in the space [mvp] transforms from */
+	void AddOccluder(const AABB& box, const glm::mat4& mvp);
+
+	/* Rasterizes the binned occluders, one job per tile when [jobs] is given */
+	void Rasterize(JobSystem* jobs = nullptr);
+
+	/* False when [worldBox] is completely behind the rasterized occluders */
+	bool IsVisible(const AABB& worldBox, const glm::mat4& viewProjection) const;
+	/* Removes the hidden objects from [visible], object i has worldBoxes.Get(i) */
+	void Cull(const AABBArray& worldBoxes, const glm::mat4& viewProjection, std::vector<unsigned int>& visible) const;
+
+	inline const float* GetDepthBuffer() const { return m_Depth.data(); }
+	inline unsigned int GetTriangleCount() const { return (unsigned int)m_Triangles.size(); }
+	inline unsigned int GetRejectedCount() const { return m_Rejected; }
+};
@@ -0,0 +1,58 @@
+#include "PipelineState.h"
+
+#include <functional>
+
+/* Mixes [value] into [seed], same scheme as boost::hash_combine */
+template<typename T>
+static void HashCombine(std::size_t& seed, const T& value)
+{
+    seed ^= std::hash<T>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+bool PipelineStateDesc::operator==(const PipelineStateDesc& other) const
+{
+    return Program == other.Program
+        && VertexInput == other.VertexInput
+        && Blend.Enabled == other.Blend.Enabled
+        && Blend.SrcFactor == other.Blend.SrcFactor
+        && Blend.DstFactor == other.Blend.DstFactor
+        && Blend.Equation == other.Blend.Equation
+        && Depth.TestEnabled == other.Depth.TestEnabled
+        && Depth.WriteEnabled == other.Depth.WriteEnabled
+        && Depth.Func == other.Depth.Func
+        && Raster.CullEnabled == other.Raster.CullEnabled
+        && Raster.CullFace == other.Raster.CullFace
+        && Raster.FrontFace == other.Raster.FrontFace
+        && ColorMask == other.ColorMask;
+}
+
+std::size_t PipelineStateDescHash::operator()(const PipelineStateDesc& desc) const
+{
+    std::size_t seed = 0;
+    HashCombine(seed, desc.Program);
+    HashCombine(seed, desc.VertexInput);
+    HashCombine(seed, desc.Blend.Enabled);
+    HashCombine(seed, desc.Blend.SrcFactor);
+    HashCombine(seed, desc.Blend.DstFactor);
+    HashCombine(seed, desc.Blend.Equation);
+    HashCombine(seed, desc.Depth.TestEnabled);
+    HashCombine(seed, desc.Depth.WriteEnabled);
+    HashCombine(seed, desc.Depth.Func);
+    HashCombine(seed, desc.Raster.CullEnabled);
+    HashCombine(seed, desc.Raster.CullFace);
+    HashCombine(seed, desc.Raster.FrontFace);
+    HashCombine(seed, desc.ColorMask);
+    return seed;
+}
+
+const PipelineState& PipelineStateCache::Get(const PipelineStateDesc& desc)
+{
+    auto it = m_States.find(desc);
+    if (it != m_States.end())
+        return *it->second;
+
+    std::size_t hash = PipelineStateDescHash()(desc);
+    unsigned int id = (unsigned int)m_States.size();
+    auto result = m_States.emplace(desc, std::unique_ptr<PipelineState>(new PipelineState(desc, hash, id)));
+    return *result.first->second;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include <GL/glew.h>
+
+class Shader;
+class VertexArray;
+
+/* Fixed-function state groups bundled by a PipelineState */
+struct BlendState
+{
+	bool Enabled = false;
+	unsigned int SrcFactor = GL_ONE;
+	unsigned int DstFactor = GL_ZERO;
+	unsigned int Equation = GL_FUNC_ADD;
+};
+
+struct DepthState
+{
+	bool TestEnabled = false;
+	bool WriteEnabled = true;
+	unsigned int Func = GL_LESS;
+};
+
+struct RasterState
+{
+	bool CullEnabled = false;
+	unsigned int CullFace = GL_BACK;
+	unsigned int FrontFace = GL_CCW;
+};
+
+/* Bits of PipelineStateDesc::ColorMask */
+enum ColorMaskBits : unsigned char
+{
+	COLOR_MASK_R = 1 << 0,
+	COLOR_MASK_G = 1 << 1,
+	COLOR_MASK_B = 1 << 2,
+	COLOR_MASK_A = 1 << 3,
+	COLOR_MASK_ALL = COLOR_MASK_R | COLOR_MASK_G | COLOR_MASK_B | COLOR_MASK_A
+};
+
+/* Everything a draw needs besides its uniforms and textures */
+struct PipelineStateDesc
+{
+	const Shader* Program = nullptr;
+	const VertexArray* VertexInput = nullptr;
+	BlendState Blend;
+	DepthState Depth;
+	RasterState Raster;
+	unsigned char ColorMask = COLOR_MASK_ALL;
+
+	bool operator==(const PipelineStateDesc& other) const;
+	bool operator!=(const PipelineStateDesc& other) const { return !(*this == other); }
+};
+
+struct PipelineStateDescHash
+{
+	std::size_t operator()(const PipelineStateDesc& desc) const;
+};
+
+/* Immutable, deduplicated pipeline state; only PipelineStateCache creates them,
+   so two draws with equal state always share the same object */
+class PipelineState
+{
+private:
+	PipelineStateDesc m_Desc;
+	std::size_t m_Hash;
+	unsigned int m_ID;
+
+	friend class PipelineStateCache;
+	PipelineState(const PipelineStateDesc& desc, std::size_t hash, unsigned int id)
+		: m_Desc(desc), m_Hash(hash), m_ID(id) {}
+public:
+	PipelineState(const PipelineState&) = delete;
+	PipelineState& operator=(const PipelineState&) = delete;
+
+	inline const PipelineStateDesc& GetDesc() const { return m_Desc; }
+	inline std::size_t GetHash() const { return m_Hash; }
+	// small dense id, handy as a sort key
+	inline unsigned int GetID() const { return m_ID; }
+};
+
+class PipelineStateCache
+{
+private:
+	std::unordered_map<PipelineStateDesc, std::unique_ptr<PipelineState>, PipelineStateDescHash> m_States;
+public:
+	/* Returns the unique PipelineState for [desc], creating it on first use */
+	const PipelineState& Get(const PipelineStateDesc& desc);
+
+	inline std::size_t GetCount() const { return m_States.size(); }
+};
@@ -0,0 +1,122 @@
+#include "ProgramBinaryCache.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include "Hash.h"
+#include "Renderer.h"
+
+/* Header written in front of every cached binary */
+struct ProgramBinaryHeader
+{
+    unsigned int magic;
+    unsigned int format;
+    unsigned int length;
+    unsigned long long key;
+};
+
+#define PROGRAM_BINARY_MAGIC 0x42505347  // "GSPB"
+
+static std::string GetGLString(GLenum name)
+{
+    const GLubyte* str = glGetString(name);
+    return str ? (const char*)str : "";
+}
+
+ProgramBinaryCache::ProgramBinaryCache(const std::string& directory)
+    : m_Directory(directory), m_Supported(false)
+{
+    /* Binaries are only meaningful for the exact driver that produced them */
+    m_DriverID = GetGLString(GL_VENDOR) + "|" + GetGLString(GL_RENDERER) + "|" + GetGLString(GL_VERSION);
+
+    /* glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS) is 0 when the driver can't save binaries */
+    if (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary)
+    {
+        int formats = 0;
+        GLCall(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats));
+        m_Supported = formats > 0;
+    }
+
+    if (m_Supported)
+    {
+        std::error_code error;
+        std::filesystem::create_directories(m_Directory, error);
+        if (error)
+        {
+            std::cout << "Warning: can't create program cache ' " << m_Directory << " ' " << std::endl;
+            m_Supported = false;
+        }
+    }
+}
+
+unsigned long long ProgramBinaryCache::GetKey(const ShaderProgramSource& source) const
+{
+    unsigned long long key = HashString(m_DriverID);
+    key = HashString(source.VertexSource, key);
+    key = HashString(source.FragmentSource, key);
+    return key;
+}
+
+std::string ProgramBinaryCache::GetPath(unsigned long long key) const
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.bin", key);
+    return (std::filesystem::path(m_Directory) / name).string();
+}
+
+unsigned int ProgramBinaryCache::Load(unsigned long long key) const
+{
+    if (!m_Supported)
+        return 0;
+
+    std::ifstream stream(GetPath(key), std::ios::binary);
+    if (!stream)
+        return 0;
+
+    ProgramBinaryHeader header;
+    if (!stream.read((char*)&header, sizeof(header)) || header.magic != PROGRAM_BINARY_MAGIC || header.key != key)
+        return 0;
+    std::vector<char> binary(header.length);
+    if (!stream.read(binary.data(), binary.size()))
+        return 0;
+
+    /* glProgramBinary() loads a previously linked program; the driver
+       may still reject it, which shows up as a failed link status */
+    unsigned int program = glCreateProgram();
+    glProgramBinary(program, header.format, binary.data(), header.length);
+    int linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (linked == GL_FALSE)
+    {
+        glDeleteProgram(program);
+        std::error_code error;
+        std::filesystem::remove(GetPath(key), error);
+        return 0;
+    }
+    return program;
+}
+
+void ProgramBinaryCache::Store(unsigned long long key, unsigned int program) const
+{
+    if (!m_Supported || program == 0)
+        return;
+
+    int linked = GL_FALSE;
+    GLCall(glGetProgramiv(program, GL_LINK_STATUS, &linked));
+    int length = 0;
+    GLCall(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length));
+    if (linked == GL_FALSE || length <= 0)
+        return;
+
+    /* glGetProgramBinary() returns the binary representation of the linked program */
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    GLCall(glGetProgramBinary(program, length, &length, &format, binary.data()));
+
+    ProgramBinaryHeader header = { PROGRAM_BINARY_MAGIC, format, (unsigned int)length, key };
+    std::ofstream stream(GetPath(key), std::ios::binary | std::ios::trunc);
+    stream.write((const char*)&header, sizeof(header));
+    stream.write(binary.data(), length);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+
+struct ShaderProgramSource;
+
+/* On-disk cache of linked program binaries (glGetProgramBinary/glProgramBinary).
+   Entries are keyed by the shader sources and the GL vendor, renderer and version,
+   so a driver update simply misses the cache instead of loading a stale binary. */
+class ProgramBinaryCache
+{
+private:
+	std::string m_Directory;
+	std::string m_DriverID;
+	bool m_Supported;
+
+	std::string GetPath(unsigned long long key) const;
+public:
+	ProgramBinaryCache(const std::string& directory);
+
+	unsigned long long GetKey(const ShaderProgramSource& source) const;
+
+	/* Returns a linked program created from the cached binary,
+	   or 0 when there is no entry or the driver rejects it */
+	unsigned int Load(unsigned long long key) const;
+	/* Writes the binary of the linked [program]; it must have been linked
+	   with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set */
+	void Store(unsigned long long key, unsigned int program) const;
+
+	inline bool IsSupported() const { return m_Supported; }
+};
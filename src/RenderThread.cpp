@@ -0,0 +1,72 @@
+#include "RenderThread.h"
+
+#include <GLFW/glfw3.h>
+
+RenderThread::RenderThread(GLFWwindow* window, std::function<void(const FramePacket&)> render)
+    : m_Window(window), m_Render(std::move(render)), m_WriteIndex(0), m_Pending(false), m_Stop(false)
+{
+    m_Thread = std::thread(&RenderThread::Loop, this);
+}
+
+RenderThread::~RenderThread()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Changed.wait(lock, [this]() { return !m_Pending; });
+        m_Stop = true;
+    }
+    m_Changed.notify_all();
+    m_Thread.join();
+    /* the resources are destroyed on this thread, their destructors need the context */
+    glfwMakeContextCurrent(m_Window);
+}
+
+void RenderThread::Loop()
+{
+    glfwMakeContextCurrent(m_Window);
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Changed.wait(lock, [this]() { return m_Pending || m_Stop; });
+            if (!m_Pending)
+                break;
+        }
+
+        /* Submit() flipped the write index, the other packet is the submitted one
+           and stays untouched until m_Pending is cleared */
+        m_Render(m_Packets[m_WriteIndex ^ 1]);
+        glfwSwapBuffers(m_Window);
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Pending = false;
+        }
+        m_Changed.notify_all();
+    }
+    glfwMakeContextCurrent(nullptr);
+}
+
+FramePacket& RenderThread::BeginFrame()
+{
+    FramePacket& packet = m_Packets[m_WriteIndex];
+    packet.Clear();
+    return packet;
+}
+
+void RenderThread::Submit()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Changed.wait(lock, [this]() { return !m_Pending; });
+        m_WriteIndex ^= 1;
+        m_Pending = true;
+    }
+    m_Changed.notify_all();
+}
+
+void RenderThread::Flush()
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_Changed.wait(lock, [this]() { return !m_Pending; });
+}
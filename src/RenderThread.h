@@ -0,0 +1,94 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "CommandBuffer.h"
+
+struct GLFWwindow;
+class Material;
+class PipelineState;
+
+/* A draw recorded by the simulation for the render thread */
+struct DrawPacket
+{
+	const PipelineState* pipeline;
+	Material* material;
+	unsigned int vertexCount;
+	glm::mat4 transform;
+};
+
+/* Material parameter change, applied on the render thread before the upload */
+struct ParameterWrite
+{
+	Material* material;
+	std::string name;
+	std::vector<unsigned char> value;
+};
+
+/* Everything the render thread needs to draw one frame; it only reads
+   the packet, the simulation owns the objects the packet points to */
+struct FramePacket
+{
+	std::vector<DrawPacket> draws;
+	std::vector<ParameterWrite> parameters;
+	// recorded ahead by the workers, executed after [draws]
+	CommandBuffer commands;
+
+	template<typename T>
+	void SetParameter(Material& material, const std::string& name, const T& value)
+	{
+		const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+		parameters.push_back({ &material, name, std::vector<unsigned char>(bytes, bytes + sizeof(T)) });
+	}
+
+	void Clear()
+	{
+		draws.clear();
+		parameters.clear();
+		commands.Clear();
+	}
+};
+
+/* Thread owning the GL context of a window.
+   The simulation fills one packet while the render thread draws the other:
+   Submit() hands the filled packet over and returns as soon as the packet
+   of the previous frame has been drawn, so frame N + 1 is simulated while
+   frame N is submitted to GL. All GL calls, including resource updates such
+   as shader reloads, belong in the render callback. */
+class RenderThread
+{
+private:
+	GLFWwindow* m_Window;
+	std::function<void(const FramePacket&)> m_Render;
+	FramePacket m_Packets[2];
+	unsigned int m_WriteIndex;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_Changed;
+	bool m_Pending;	// a submitted packet hasn't finished drawing
+	bool m_Stop;
+	std::thread m_Thread;
+
+	void Loop();
+public:
+	/* Takes over the context of [window], which must not be current on the calling thread */
+	RenderThread(GLFWwindow* window, std::function<void(const FramePacket&)> render);
+	/* Stops the thread and makes the context current on the calling thread again */
+	~RenderThread();
+
+	RenderThread(const RenderThread&) = delete;
+	RenderThread& operator=(const RenderThread&) = delete;
+
+	/* The packet to fill for the next frame, emptied */
+	FramePacket& BeginFrame();
+	/* Hands the packet to the render thread, blocks while it is still drawing the previous one */
+	void Submit();
+	/* Waits until every submitted packet has been drawn */
+	void Flush();
+};
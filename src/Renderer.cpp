@@ -2,6 +2,8 @@
 // based on the code of The Cherno OpenGL tutorial
 
 #include <iostream> 
+#include <algorithm>
+#include <cstring>
 #include "Renderer.h"
 
 
@@ -23,6 +25,23 @@ bool GLLogCall(const char* function, const char* file, int line) {
     return true;
 }
 
+/* glEnable()/glDisable() a server-side capability */
+static void SetCapability(GLenum capability, bool enabled)
+{
+    if (enabled)
+    {
+        GLCall(glEnable(capability));
+    }
+    else
+    {
+        GLCall(glDisable(capability));
+    }
+}
+
+Renderer::Renderer()
+    : m_CurrentPipeline(nullptr), m_BoundProgram(0), m_BoundVertexArray(0)
+{
+}
 
 void Renderer::Clear() const
 {
@@ -40,4 +59,204 @@ void Renderer::Draw(const VertexArray& va, const Shader& shader) const
        It specifies multiple geometric primitives with very few subroutine calls. */
     GLCall(glDrawArrays(GL_TRIANGLES, 0, 36));
     va.Unbind();
-}
\ No newline at end of file
+}
+
+void Renderer::Draw(const PipelineState& pipeline, unsigned int vertexCount)
+{
+    SetPipelineState(pipeline);
+    GLCall(glDrawArrays(GL_TRIANGLES, 0, vertexCount));
+}
+
+void Renderer::SetPipelineState(const PipelineState& pipeline)
+{
+    const PipelineStateDesc& next = pipeline.GetDesc();
+
+    /* Program and vertex array are compared by GL name, since
+       the objects behind the pointers can be recreated */
+    unsigned int program = next.Program ? next.Program->m_RendererID : 0;
+    if (m_CurrentPipeline == nullptr || program != m_BoundProgram)
+    {
+        /* glUseProgram() installs [program] as part of current rendering state */
+        GLCall(glUseProgram(program));
+        m_BoundProgram = program;
+    }
+    unsigned int vertexArray = next.VertexInput ? next.VertexInput->GetRendererID() : 0;
+    if (m_CurrentPipeline == nullptr || vertexArray != m_BoundVertexArray)
+    {
+        /* glBindVertexArray() binds the vertex array object named [vertexArray] */
+        GLCall(glBindVertexArray(vertexArray));
+        m_BoundVertexArray = vertexArray;
+    }
+
+    if (m_CurrentPipeline == &pipeline)
+        return;
+
+    /* The first pipeline is applied in full, later ones only where they differ */
+    bool force = m_CurrentPipeline == nullptr;
+    const PipelineStateDesc& prev = force ? next : m_CurrentPipeline->GetDesc();
+
+    /* Blending */
+    if (force || prev.Blend.Enabled != next.Blend.Enabled)
+        SetCapability(GL_BLEND, next.Blend.Enabled);
+    if (force || prev.Blend.SrcFactor != next.Blend.SrcFactor || prev.Blend.DstFactor != next.Blend.DstFactor)
+    {
+        GLCall(glBlendFunc(next.Blend.SrcFactor, next.Blend.DstFactor));
+    }
+    if (force || prev.Blend.Equation != next.Blend.Equation)
+    {
+        GLCall(glBlendEquation(next.Blend.Equation));
+    }
+
+    /* Depth */
+    if (force || prev.Depth.TestEnabled != next.Depth.TestEnabled)
+        SetCapability(GL_DEPTH_TEST, next.Depth.TestEnabled);
+    if (force || prev.Depth.WriteEnabled != next.Depth.WriteEnabled)
+    {
+        GLCall(glDepthMask(next.Depth.WriteEnabled ? GL_TRUE : GL_FALSE));
+    }
+    if (force || prev.Depth.Func != next.Depth.Func)
+    {
+        GLCall(glDepthFunc(next.Depth.Func));
+    }
+
+    /* Rasterizer */
+    if (force || prev.Raster.CullEnabled != next.Raster.CullEnabled)
+        SetCapability(GL_CULL_FACE, next.Raster.CullEnabled);
+    if (force || prev.Raster.CullFace != next.Raster.CullFace)
+    {
+        GLCall(glCullFace(next.Raster.CullFace));
+    }
+    if (force || prev.Raster.FrontFace != next.Raster.FrontFace)
+    {
+        GLCall(glFrontFace(next.Raster.FrontFace));
+    }
+
+    /* Color writes */
+    if (force || prev.ColorMask != next.ColorMask)
+    {
+        GLCall(glColorMask((next.ColorMask & COLOR_MASK_R) ? GL_TRUE : GL_FALSE,
+                           (next.ColorMask & COLOR_MASK_G) ? GL_TRUE : GL_FALSE,
+                           (next.ColorMask & COLOR_MASK_B) ? GL_TRUE : GL_FALSE,
+                           (next.ColorMask & COLOR_MASK_A) ? GL_TRUE : GL_FALSE));
+    }
+
+    m_CurrentPipeline = &pipeline;
+}
+
+void Renderer::InvalidateState()
+{
+    m_CurrentPipeline = nullptr;
+}
+
+void Renderer::Submit(const PipelineState& pipeline, Material& material, unsigned int vertexCount, const glm::mat4& transform)
+{
+    ASSERT(pipeline.GetDesc().Program == &material.GetShader());
+    unsigned long long sortKey = ((unsigned long long)pipeline.GetID() << 32) | material.GetID();
+    m_Queue.push_back({ sortKey, &pipeline, &material, vertexCount, transform });
+}
+
+void Renderer::Flush()
+{
+    std::stable_sort(m_Queue.begin(), m_Queue.end(),
+        [](const DrawCommand& a, const DrawCommand& b) { return a.sortKey < b.sortKey; });
+
+    /* Consecutive draws sharing a material only pay for their own transform */
+    Material* currentMaterial = nullptr;
+    UniformHandle transformUniform;
+    for (const DrawCommand& command : m_Queue)
+    {
+        SetPipelineState(*command.pipeline);
+        if (command.material != currentMaterial)
+        {
+            command.material->Bind();
+            currentMaterial = command.material;
+            transformUniform = currentMaterial->GetTransformUniform();
+        }
+        currentMaterial->GetShader().SetUniform(transformUniform, command.transform);
+        GLCall(glDrawArrays(GL_TRIANGLES, 0, command.vertexCount));
+    }
+    m_Queue.clear();
+}
+
+/* Copies the payload of the command at [data] (unaligned in the stream) */
+template<typename T>
+static inline T ReadCommand(const unsigned char* data)
+{
+    T payload;
+    std::memcpy(&payload, data + sizeof(CommandHeader), sizeof(T));
+    return payload;
+}
+
+void Renderer::Execute(const CommandBuffer& commands)
+{
+    Material* currentMaterial = nullptr;
+    const unsigned char* data = commands.GetData();
+    const unsigned char* end = data + commands.GetSize();
+    while (data < end)
+    {
+        CommandHeader header;
+        std::memcpy(&header, data, sizeof(header));
+        switch (header.type)
+        {
+        case CommandType::BindPipeline:
+            SetPipelineState(*ReadCommand<BindPipelineCommand>(data).pipeline);
+            break;
+        case CommandType::BindMaterial:
+        {
+            Material* material = ReadCommand<BindMaterialCommand>(data).material;
+            if (material != currentMaterial)
+            {
+                material->Bind();
+                currentMaterial = material;
+            }
+            break;
+        }
+        case CommandType::BindUniformBuffer:
+        {
+            BindUniformBufferCommand command = ReadCommand<BindUniformBufferCommand>(data);
+            command.buffer->BindRange(command.binding, command.offset, command.size);
+            break;
+        }
+        case CommandType::SetUniformInt:
+        {
+            SetUniformCommand<int> command = ReadCommand<SetUniformCommand<int>>(data);
+            command.shader->SetUniform(command.handle, command.value);
+            break;
+        }
+        case CommandType::SetUniformFloat:
+        {
+            SetUniformCommand<float> command = ReadCommand<SetUniformCommand<float>>(data);
+            command.shader->SetUniform(command.handle, command.value);
+            break;
+        }
+        case CommandType::SetUniformVec4:
+        {
+            SetUniformCommand<glm::vec4> command = ReadCommand<SetUniformCommand<glm::vec4>>(data);
+            command.shader->SetUniform(command.handle, command.value);
+            break;
+        }
+        case CommandType::SetUniformMat4:
+        {
+            SetUniformCommand<glm::mat4> command = ReadCommand<SetUniformCommand<glm::mat4>>(data);
+            command.shader->SetUniform(command.handle, command.value);
+            break;
+        }
+        case CommandType::Draw:
+        {
+            DrawArraysCommand command = ReadCommand<DrawArraysCommand>(data);
+            GLCall(glDrawArrays(GL_TRIANGLES, command.first, command.vertexCount));
+            break;
+        }
+        case CommandType::DrawIndexed:
+        {
+            DrawIndexedCommand command = ReadCommand<DrawIndexedCommand>(data);
+            command.indices->Bind();
+            GLCall(glDrawElements(GL_TRIANGLES, command.indexCount, GL_UNSIGNED_INT, nullptr));
+            break;
+        }
+        default:
+            ASSERT(false);
+        }
+        data += sizeof(CommandHeader) + header.size;
+    }
+}
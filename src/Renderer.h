@@ -10,6 +10,10 @@
 #include "VertexArray.h"
 #include "IndexBuffer.h"
 #include "Shader.h"
+#include "PipelineState.h"
+#include "Material.h"
+#include "CommandBuffer.h"
+#include <vector>
 
 /* STARTS ERROR DETECTION MACRO AND FUNCTIONS */
 #define ASSERT(x) if (!(x)) __debugbreak();
@@ -20,10 +24,43 @@ void GLClearError();
 bool GLLogCall(const char* function, const char* file, int line);
 /* ENDS ERROR DETECTION MACRO AND FUNCTIONS */
 
+/* A queued draw, ordered by pipeline then material before submission */
+struct DrawCommand
+{
+    unsigned long long sortKey;
+    const PipelineState* pipeline;
+    Material* material;
+    unsigned int vertexCount;
+    glm::mat4 transform;
+};
+
 class Renderer
 {
+private:
+    std::vector<DrawCommand> m_Queue;
+
+    /* Last state applied through SetPipelineState(), used to skip redundant GL calls */
+    const PipelineState* m_CurrentPipeline;
+    unsigned int m_BoundProgram;
+    unsigned int m_BoundVertexArray;
+
 public:
+    Renderer();
+
     void Clear() const;
     void Draw(const VertexArray& va, const Shader& shader) const;
+    void Draw(const PipelineState& pipeline, unsigned int vertexCount);
+
+    /* Applies only the fields of [pipeline] that differ from the current one */
+    void SetPipelineState(const PipelineState& pipeline);
+    /* Forgets the tracked state, call after touching GL state outside the renderer */
+    void InvalidateState();
+
+    /* Queues a draw of [vertexCount] vertices; [transform] goes to the "transformations" uniform */
+    void Submit(const PipelineState& pipeline, Material& material, unsigned int vertexCount, const glm::mat4& transform);
+    /* Sorts the queued draws by pipeline and material and issues them */
+    void Flush();
 
+    /* Replays recorded commands in order; pipeline and material binds are still filtered */
+    void Execute(const CommandBuffer& commands);
 };
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include "ResourceFactory.h"
+
+#include <chrono>
+#include <iostream>
+#include "IndexBuffer.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "VertexBuffer.h"
+#include "vendor/stb_image/stb_image.h"
+
+ResourceFactory::ResourceFactory()
+    : m_Head(&m_Stub), m_Tail(&m_Stub), m_Pending(0)
+{
+    m_Stub.next = nullptr;
+}
+
+ResourceFactory::~ResourceFactory()
+{
+    /* deletions queued while running requests are picked up by the same loop */
+    while (Process(1e9) > 0)
+    {
+    }
+}
+
+void ResourceFactory::Push(Request* request)
+{
+    request->next.store(nullptr, std::memory_order_relaxed);
+    /* the exchange orders the producers; the queue is briefly unlinked until
+       the previous head points at the new request, Pop() waits that out */
+    Request* previous = m_Head.exchange(request, std::memory_order_acq_rel);
+    previous->next.store(request, std::memory_order_release);
+}
+
+ResourceFactory::Request* ResourceFactory::Pop()
+{
+    Request* tail = m_Tail;
+    Request* next = tail->next.load(std::memory_order_acquire);
+    if (tail == &m_Stub)
+    {
+        if (!next)
+            return nullptr;
+        m_Tail = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+    if (next)
+    {
+        m_Tail = next;
+        return tail;
+    }
+    /* [tail] is the last request unless a producer is between its two steps */
+    if (tail != m_Head.load(std::memory_order_acquire))
+        return nullptr;
+    /* re-insert the stub so [tail] gets a successor and can be handed out */
+    Push(&m_Stub);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next)
+    {
+        m_Tail = next;
+        return tail;
+    }
+    return nullptr;
+}
+
+void ResourceFactory::Enqueue(std::function<void()> work)
+{
+    Request* request = new Request();
+    request->work = std::move(work);
+    m_Pending.fetch_add(1, std::memory_order_relaxed);
+    Push(request);
+}
+
+unsigned int ResourceFactory::Process(double budgetMilliseconds)
+{
+    auto start = std::chrono::steady_clock::now();
+    unsigned int processed = 0;
+    while (Request* request = Pop())
+    {
+        request->work();
+        delete request;
+        m_Pending.fetch_sub(1, std::memory_order_relaxed);
+        processed++;
+
+        double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (elapsed >= budgetMilliseconds)
+            break;
+    }
+    return processed;
+}
+
+ResourceFuture<VertexBuffer> ResourceFactory::CreateVertexBuffer(std::vector<unsigned char> data)
+{
+    auto promise = std::make_shared<std::promise<std::shared_ptr<VertexBuffer>>>();
+    ResourceFuture<VertexBuffer> future = promise->get_future().share();
+    Enqueue([this, promise, data = std::move(data)]()
+    {
+        promise->set_value(Adopt(new VertexBuffer(data.data(), (unsigned int)data.size())));
+    });
+    return future;
+}
+
+ResourceFuture<IndexBuffer> ResourceFactory::CreateIndexBuffer(std::vector<unsigned int> indices)
+{
+    auto promise = std::make_shared<std::promise<std::shared_ptr<IndexBuffer>>>();
+    ResourceFuture<IndexBuffer> future = promise->get_future().share();
+    Enqueue([this, promise, indices = std::move(indices)]()
+    {
+        promise->set_value(Adopt(new IndexBuffer(indices.data(), (unsigned int)indices.size())));
+    });
+    return future;
+}
+
+ResourceFuture<Texture> ResourceFactory::CreateTexture(const std::string& path)
+{
+    /* the per-thread flip setting leaves other decoding threads alone */
+    int width = 0, height = 0, channels = 0;
+    stbi_set_flip_vertically_on_load_thread(1);
+    unsigned char* decoded = stbi_load(path.c_str(), &width, &height, &channels, 4);
+    if (!decoded)
+        std::cout << "Warning: texture ' " << path << " ' couldn't be decoded " << std::endl;
+    std::shared_ptr<unsigned char> pixels(decoded, [](unsigned char* data) { if (data) stbi_image_free(data); });
+
+    auto promise = std::make_shared<std::promise<std::shared_ptr<Texture>>>();
+    ResourceFuture<Texture> future = promise->get_future().share();
+    Enqueue([this, promise, pixels, width, height]()
+    {
+        promise->set_value(Adopt(new Texture(pixels.get(), width, height)));
+    });
+    return future;
+}
+
+ResourceFuture<Shader> ResourceFactory::CreateShader(const std::string& filepath, const ShaderDefines& defines /*= {}*/)
+{
+    ShaderProgramSource source = Shader::ParseShader(filepath, defines);
+    return Create<Shader>(filepath, source);
+}
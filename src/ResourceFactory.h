@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "ShaderPreprocessor.h"
+
+class VertexBuffer;
+class IndexBuffer;
+class Texture;
+class Shader;
+
+/* A GL resource that becomes available once the GL thread created it */
+template<typename T>
+using ResourceFuture = std::shared_future<std::shared_ptr<T>>;
+
+/* Creates GL objects on behalf of threads that have no GL context.
+   Any thread queues a creation request and gets a future right away; the
+   GL thread runs the requests in Process() within a time budget per frame.
+   The queue is a lock-free multiple producer, single consumer list, so
+   loader threads never wait on the render thread. CPU work such as file
+   reading and image decoding happens on the requesting thread.
+   Releasing the last reference of a resource queues its deletion as well,
+   so resources may be dropped on any thread; the factory must outlive them. */
+class ResourceFactory
+{
+private:
+	struct Request
+	{
+		std::atomic<Request*> next;
+		std::function<void()> work;
+	};
+
+	std::atomic<Request*> m_Head;	// newest request, producers swap themselves in here
+	Request* m_Tail;				// oldest request, only touched by the GL thread
+	Request m_Stub;
+	std::atomic<unsigned int> m_Pending;
+
+	void Enqueue(std::function<void()> work);
+	void Push(Request* request);
+	Request* Pop();
+
+	template<typename T>
+	std::shared_ptr<T> Adopt(T* resource)
+	{
+		return std::shared_ptr<T>(resource, [this](T* pointer) { Enqueue([pointer]() { delete pointer; }); });
+	}
+public:
+	ResourceFactory();
+	/* Runs the requests still queued, so the GL context has to be current */
+	~ResourceFactory();
+
+	ResourceFactory(const ResourceFactory&) = delete;
+	ResourceFactory& operator=(const ResourceFactory&) = delete;
+
+	/* Queues new T(args...), the arguments are copied into the request */
+	template<typename T, typename... Args>
+	ResourceFuture<T> Create(Args... args)
+	{
+		auto promise = std::make_shared<std::promise<std::shared_ptr<T>>>();
+		ResourceFuture<T> future = promise->get_future().share();
+		Enqueue([this, promise, arguments = std::make_tuple(std::move(args)...)]()
+		{
+			promise->set_value(Adopt(std::apply([](const auto&... values) { return new T(values...); }, arguments)));
+		});
+		return future;
+	}
+
+	/* Queues [create] and hands its result to [done] on the GL thread, for callers
+	   that continue by callback rather than by waiting on a future */
+	template<typename T>
+	void CreateAsync(std::function<T*()> create, std::function<void(std::shared_ptr<T>)> done)
+	{
+		Enqueue([this, create = std::move(create), done = std::move(done)]() { done(Adopt(create())); });
+	}
+
+	ResourceFuture<VertexBuffer> CreateVertexBuffer(std::vector<unsigned char> data);
+	ResourceFuture<IndexBuffer> CreateIndexBuffer(std::vector<unsigned int> indices);
+	/* Decodes the image on the calling thread, only the upload is queued */
+	ResourceFuture<Texture> CreateTexture(const std::string& path);
+	/* Reads and preprocesses the file on the calling thread, only compilation is queued */
+	ResourceFuture<Shader> CreateShader(const std::string& filepath, const ShaderDefines& defines = {});
+
+	/* GL thread: runs queued requests until the queue is empty or [budgetMilliseconds]
+	   passed, at least one request per call; returns how many ran */
+	unsigned int Process(double budgetMilliseconds);
+
+	inline unsigned int GetPendingCount() const { return m_Pending.load(std::memory_order_relaxed); }
+};
@@ -0,0 +1,103 @@
+#include "SceneGraph.h"
+
+#include <algorithm>
+#include "JobSystem.h"
+
+/* Levels smaller than this are updated on the calling thread */
+#define SCENE_PARALLEL_THRESHOLD 4096
+/* Nodes per job when a level is split */
+#define SCENE_JOB_GRAIN 1024
+
+SceneGraph::SceneGraph()
+    : m_UpdatedCount(0)
+{
+}
+
+unsigned int SceneGraph::Create(const glm::mat4& local /*= glm::mat4(1.0f)*/, unsigned int parent /*= SCENE_ROOT*/)
+{
+    unsigned int depth = parent == SCENE_ROOT ? 0 : m_Locations[parent].depth + 1;
+    if (depth == m_Levels.size())
+        m_Levels.push_back({ {}, {}, {}, {}, {}, false, false });
+
+    /* appended at the end of its level, existing slots never move */
+    Level& level = m_Levels[depth];
+    unsigned int slot = (unsigned int)level.local.size();
+    level.parentSlots.push_back(parent == SCENE_ROOT ? SCENE_ROOT : m_Locations[parent].slot);
+    level.local.push_back(local);
+    level.world.push_back(local);
+    level.dirty.push_back(1);
+    level.changed.push_back(0);
+    level.anyDirty = true;
+
+    unsigned int node = (unsigned int)m_Locations.size();
+    m_Locations.push_back({ depth, slot });
+    return node;
+}
+
+void SceneGraph::SetLocal(unsigned int node, const glm::mat4& local)
+{
+    Level& level = m_Levels[m_Locations[node].depth];
+    unsigned int slot = m_Locations[node].slot;
+    level.local[slot] = local;
+    level.dirty[slot] = 1;
+    level.anyDirty = true;
+}
+
+void SceneGraph::UpdateRange(unsigned int depth, unsigned int begin, unsigned int end)
+{
+    Level& level = m_Levels[depth];
+    const Level* parentLevel = depth > 0 ? &m_Levels[depth - 1] : nullptr;
+    /* when nothing above changed only the dirty flags need looking at */
+    bool parentChanged = parentLevel && parentLevel->anyChanged;
+
+    for (unsigned int i = begin; i < end; i++)
+    {
+        unsigned int parent = level.parentSlots[i];
+        bool recompute = level.dirty[i] || (parentChanged && parentLevel->changed[parent]);
+        level.changed[i] = recompute;
+        if (!recompute)
+            continue;
+        level.world[i] = parentLevel ? parentLevel->world[parent] * level.local[i] : level.local[i];
+        level.dirty[i] = 0;
+    }
+}
+
+void SceneGraph::UpdateLevel(unsigned int depth, JobSystem* jobs)
+{
+    Level& level = m_Levels[depth];
+    bool parentChanged = depth > 0 && m_Levels[depth - 1].anyChanged;
+    if (!level.anyDirty && !parentChanged)
+    {
+        /* the flags of the last update must not leak into the next level */
+        if (level.anyChanged)
+            std::fill(level.changed.begin(), level.changed.end(), 0);
+        level.anyChanged = false;
+        return;
+    }
+
+    unsigned int count = (unsigned int)level.local.size();
+    if (!jobs || count < SCENE_PARALLEL_THRESHOLD)
+    {
+        UpdateRange(depth, 0, count);
+    }
+    else
+    {
+        /* nodes of one level only read the level above, so the slots split freely */
+        jobs->ParallelFor(count, SCENE_JOB_GRAIN, [this, depth](unsigned int begin, unsigned int end)
+        {
+            UpdateRange(depth, begin, end);
+        });
+    }
+
+    unsigned int updated = (unsigned int)std::count(level.changed.begin(), level.changed.end(), (unsigned char)1);
+    m_UpdatedCount += updated;
+    level.anyChanged = updated > 0;
+    level.anyDirty = false;
+}
+
+void SceneGraph::Update(JobSystem* jobs /*= nullptr*/)
+{
+    m_UpdatedCount = 0;
+    for (unsigned int depth = 0; depth < m_Levels.size(); depth++)
+        UpdateLevel(depth, jobs);
+}
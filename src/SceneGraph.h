@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+class JobSystem;
+
+/* Parent handle of the nodes at the top of the hierarchy */
+#define SCENE_ROOT 0xFFFFFFFFu
+
+/* Transform hierarchy.
+   Nodes are stored per depth level, every array of a level is contiguous and
+   a node refers to its parent by slot in the level above, so a level only
+   reads the world matrices the previous level just wrote and its nodes can
+   be updated in parallel. Only dirty nodes and the descendants of dirty
+   nodes are recomputed, levels without changes are skipped entirely. */
+class SceneGraph
+{
+private:
+	struct Level
+	{
+		std::vector<unsigned int> parentSlots;	// slot of the parent in the level above
+		std::vector<glm::mat4> local;
+		std::vector<glm::mat4> world;
+		std::vector<unsigned char> dirty;		// local changed since the last update
+		std::vector<unsigned char> changed;		// world rewritten by the last update
+		bool anyDirty;
+		bool anyChanged;
+	};
+
+	struct Location
+	{
+		unsigned int depth;
+		unsigned int slot;
+	};
+
+	std::vector<Level> m_Levels;
+	std::vector<Location> m_Locations;	// node handle to level and slot
+	unsigned int m_UpdatedCount;
+
+	void UpdateLevel(unsigned int depth, JobSystem* jobs);
+	void UpdateRange(unsigned int depth, unsigned int begin, unsigned int end);
+public:
+	SceneGraph();
+
+	/* Adds a node under [parent] (SCENE_ROOT for none) and returns its handle */
+	unsigned int Create(const glm::mat4& local = glm::mat4(1.0f), unsigned int parent = SCENE_ROOT);
+
+	void SetLocal(unsigned int node, const glm::mat4& local);
+
+	/* Recomputes the world matrices of dirty nodes and their subtrees, level by level;
+	   large levels are split into jobs when [jobs] is given */
+	void Update(JobSystem* jobs = nullptr);
+
+	inline const glm::mat4& GetLocal(unsigned int node) const { return m_Levels[m_Locations[node].depth].local[m_Locations[node].slot]; }
+	inline const glm::mat4& GetWorld(unsigned int node) const { return m_Levels[m_Locations[node].depth].world[m_Locations[node].slot]; }
+	inline unsigned int GetDepth(unsigned int node) const { return m_Locations[node].depth; }
+	inline unsigned int GetLevelCount() const { return (unsigned int)m_Levels.size(); }
+	inline unsigned int GetNodeCount() const { return (unsigned int)m_Locations.size(); }
+	/* Number of world matrices the last Update() recomputed */
+	inline unsigned int GetUpdatedCount() const { return m_UpdatedCount; }
+};
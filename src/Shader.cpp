@@ -1,59 +1,97 @@
 #include "Shader.h"
 #include <iostream>
-#include <fstream>  
 #include <string>
-#include <sstream>
+#include <algorithm>
+#include <cstring>
 #include "Renderer.h"
+#include "ProgramBinaryCache.h"
 
-Shader::Shader(const std::string& filepath)
-	: m_FilePath(filepath), m_RendererID(0)
+Shader::Shader(const std::string& filepath, ProgramBinaryCache* binaryCache /*= nullptr*/, bool deferred /*= false*/,
+    const ShaderDefines& defines /*= ShaderDefines()*/)
+	: m_FilePath(filepath), m_Defines(defines), m_SkippedUploads(0), m_BinaryCache(nullptr), m_RendererID(0)
 {
-    ShaderProgramSource source = ParseShader(filepath);
-    m_RendererID = CreateShader(source.VertexSource, source.FragmentSource);
+    ShaderProgramSource source = ParseShader(filepath, defines);
+    m_Dependencies = source.Dependencies;
+
+    if (binaryCache && binaryCache->IsSupported())
+    {
+        /* A cache hit skips compiling and linking, a miss or a
+           rejected binary falls back to compiling and refills the entry */
+        m_BinaryCache = binaryCache;
+        m_RendererID = binaryCache->Load(binaryCache->GetKey(source));
+        if (m_RendererID != 0)
+        {
+            Reflect();
+            return;
+        }
+    }
+    CreateShader(source, m_Pending);
+    m_RendererID = m_Pending.program;
+
+    if (!deferred)
+        Finish();
+}
+
+Shader::Shader(const std::string& name, const ShaderProgramSource& source, ProgramBinaryCache* binaryCache /*= nullptr*/,
+    bool deferred /*= false*/)
+	: m_FilePath(name), m_SkippedUploads(0), m_BinaryCache(nullptr), m_RendererID(0)
+{
+    m_Dependencies = source.Dependencies;
+    if (binaryCache && binaryCache->IsSupported())
+    {
+        m_BinaryCache = binaryCache;
+        m_RendererID = binaryCache->Load(binaryCache->GetKey(source));
+        if (m_RendererID != 0)
+        {
+            Reflect();
+            return;
+        }
+    }
+    CreateShader(source, m_Pending);
+    m_RendererID = m_Pending.program;
+
+    if (!deferred)
+        Finish();
 }
 
 Shader::~Shader()
 {
+    /* glDeleteShader(0) and glDeleteProgram(0) are silently ignored */
+    glDeleteShader(m_Pending.vertex);
+    glDeleteShader(m_Pending.fragment);
+    glDeleteShader(m_Reload.vertex);
+    glDeleteShader(m_Reload.fragment);
+    glDeleteProgram(m_Reload.program);
     GLCall(glDeleteProgram(m_RendererID));
 }
 
 /* Function to read from a shader file */
-ShaderProgramSource Shader::ParseShader(const std::string& filepath)
+ShaderProgramSource Shader::ParseShader(const std::string& filepath, const ShaderDefines& defines /*= ShaderDefines()*/)
 {
-    /*open the file*/
-    std::ifstream stream(filepath);
+    /* expand #include first, an included file may belong to either stage */
+    std::vector<std::string> dependencies;
+    std::string text = ShaderPreprocessor::ResolveIncludes(filepath, dependencies);
 
-    enum class ShaderType
-    {
-        NONE = -1, VERTEX = 0, FRAGMENT = 1
-    };
-
-    std::string line;
-    std::stringstream ss[2];
-    ShaderType type = ShaderType::NONE;
+    ShaderProgramSource source;
+    ShaderPreprocessor::SplitStages(text, source.VertexSource, source.FragmentSource);
+    /* variant defines go into both stages */
+    source.VertexSource = ShaderPreprocessor::InjectDefines(source.VertexSource, defines);
+    source.FragmentSource = ShaderPreprocessor::InjectDefines(source.FragmentSource, defines);
+    source.Dependencies = std::move(dependencies);
+    return source;
+}
 
-    /* read line by line and find the beginning of each shader */
-    while (getline(stream, line))
-    {
-        if (line.find("#shader") != std::string::npos)
-        {
-            if (line.find("vertex") != std::string::npos)
-                /* Set mode to vertex */
-                type = ShaderType::VERTEX;
-            else if (line.find("fragment") != std::string::npos)
-                /* Set mode to fragment */
-                type = ShaderType::FRAGMENT;
-        }
-        else
-        {
-            if (type != ShaderType::NONE)
-                ss[(int)type] << line << '\n';
-        }
-    }
-    return { ss[0].str(), ss[1].str() };
+/* Builds the source of a shader compiled into the executable, see EmbeddedShaders.h */
+ShaderProgramSource Shader::ParseEmbedded(const EmbeddedShader& shader, const ShaderDefines& defines /*= ShaderDefines()*/)
+{
+    ShaderProgramSource source;
+    source.VertexSource = ShaderPreprocessor::InjectDefines(std::string(shader.vertex), defines);
+    source.FragmentSource = ShaderPreprocessor::InjectDefines(std::string(shader.fragment), defines);
+    return source;
 }
 
-/* Compiles and creates shader objects and returns the id */
+/* Compiles and creates shader objects and returns the id,
+   the compile status is checked later by CheckCompileStatus() */
 unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
 {
     /* glCreateShader() creates an empty shader object and
@@ -65,9 +103,15 @@ unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
        by the source code in the array of strings specified by [src] */
     glShaderSource(id, 1, &src, nullptr);
     /* Here glCompileShader() compiles the source code strings
-       that have been stored in the [id] shader object */
+       that have been stored in the [id] shader object; querying the result
+       right away would wait for the driver, so that is left for later */
     glCompileShader(id);
+    return id;
+}
 
+/* Prints the information log of the [id] shader if it failed to compile */
+bool Shader::CheckCompileStatus(unsigned int type, unsigned int id)
+{
     /* Starts error handling */
     int result;
     /* Here glGetShaderiv() returns the compile status from the [id] shader */
@@ -83,45 +127,151 @@ unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
         glGetShaderInfoLog(id, length, &length, message);
         std::cout << "Failed to compile " << (type == GL_VERTEX_SHADER ? "vertex" : "fragment") << "shader!" << std::endl;
         std::cout << message << std::endl;
-        /* Here glDeleteShader() frees the memory
-           and invalidates the name associated with the [id] shader object*/
-        glDeleteShader(id);
-        return 0;
+        free(message);
+        return false;
     }
     /* Ends error handling */
-    return id;
+    return true;
 }
 
 /*Creates a program containg vertex and fragment shader*/
-unsigned int Shader::CreateShader(const std::string& vertexShader, const std::string& fragmentShader) {
+void Shader::CreateShader(const ShaderProgramSource& source, PendingProgram& pending) {
     /* glCreateProgram() creates an empty program object for the shader,
        it goes to CompileShader() and back here, it returns
        a non-zero value by which it can be referenced */
-    unsigned int program = glCreateProgram();
+    pending.program = glCreateProgram();
     // Here CompileShader() compiles the vertex shader and returns its id
-    unsigned int vs = CompileShader(GL_VERTEX_SHADER, vertexShader);
+    pending.vertex = CompileShader(GL_VERTEX_SHADER, source.VertexSource);
     // Here CompileShader() compiles the fragment shader and returns its id
-    unsigned int fs = CompileShader(GL_FRAGMENT_SHADER, fragmentShader);
-
-    /* Here glAttachShader() binds the [vs] shader object to the [program] program object */
-    glAttachShader(program, vs);
-    /* Here glAttachShader() binds the [fs] shader object to the [program] program object */
-    glAttachShader(program, fs);
-    /* glLinkProgram() links the [program] program
-       using the binded shader to build an executable for the GPU */
-    glLinkProgram(program);
+    pending.fragment = CompileShader(GL_FRAGMENT_SHADER, source.FragmentSource);
+
+    /* Here glAttachShader() binds the vertex shader object to the program object */
+    glAttachShader(pending.program, pending.vertex);
+    /* Here glAttachShader() binds the fragment shader object to the program object */
+    glAttachShader(pending.program, pending.fragment);
+    /* glProgramParameteri() asks the driver to keep the linked binary
+       around so that glGetProgramBinary() can return it afterwards */
+    if (m_BinaryCache)
+    {
+        pending.binaryKey = m_BinaryCache->GetKey(source);
+        glProgramParameteri(pending.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    /* glLinkProgram() links the program using the binded shader
+       to build an executable for the GPU; like compiling, it runs
+       asynchronously until CheckProgram() asks for the result */
+    glLinkProgram(pending.program);
+}
+
+/* Checks compile and link status of [pending] and prints the logs,
+   then frees its shader objects; waits if the driver isn't done yet */
+bool Shader::CheckProgram(PendingProgram& pending)
+{
+    bool compiled = CheckCompileStatus(GL_VERTEX_SHADER, pending.vertex);
+    compiled = CheckCompileStatus(GL_FRAGMENT_SHADER, pending.fragment) && compiled;
+
+    int linked = GL_FALSE;
+    glGetProgramiv(pending.program, GL_LINK_STATUS, &linked);
+    if (compiled && linked == GL_FALSE)
+    {
+        int length;
+        glGetProgramiv(pending.program, GL_INFO_LOG_LENGTH, &length);
+        char* message = (char*)malloc(length * sizeof(char));
+        /* glGetProgramInfoLog() returns the information log for the program */
+        glGetProgramInfoLog(pending.program, length, &length, message);
+        std::cout << "Failed to link shader " << m_FilePath << "!" << std::endl;
+        std::cout << message << std::endl;
+        free(message);
+    }
     /* glValidateProgram() validates a program object,
        checks if the executables contained can execute */
-    glValidateProgram(program);
+    glValidateProgram(pending.program);
 
     /* Here glDeleteShader() frees the memory and invalidates the name associated
-       with the [vs] shader object to detach the intermediates*/
-    glDeleteShader(vs);
-    /* Here glDeleteShader() frees the memory and invalidates the name associated
-       with the [fs] shader object to detach the intermediates*/
-    glDeleteShader(fs);
+       with the shader objects to detach the intermediates*/
+    glDeleteShader(pending.vertex);
+    glDeleteShader(pending.fragment);
+    pending.vertex = 0;
+    pending.fragment = 0;
+
+    if (m_BinaryCache && linked == GL_TRUE)
+        m_BinaryCache->Store(pending.binaryKey, pending.program);
+    return linked == GL_TRUE;
+}
 
-    return program;
+/* True when the driver is done with [pending], never blocks */
+bool Shader::IsComplete(const PendingProgram& pending)
+{
+    if (pending.vertex == 0 && pending.fragment == 0)
+        return true;
+    /* GL_COMPLETION_STATUS_KHR can be polled without waiting for the compiler threads */
+    if (!CanPollCompletion())
+        return true;
+    int completed = GL_FALSE;
+    glGetProgramiv(pending.program, GL_COMPLETION_STATUS_KHR, &completed);
+    return completed == GL_TRUE;
+}
+
+bool Shader::CanPollCompletion()
+{
+    return GLEW_KHR_parallel_shader_compile != 0;
+}
+
+bool Shader::IsReady() const
+{
+    return IsComplete(m_Pending);
+}
+
+void Shader::Finish()
+{
+    if (m_Pending.vertex == 0 && m_Pending.fragment == 0)
+        return;
+    CheckProgram(m_Pending);
+    m_Pending = PendingProgram();
+    Reflect();
+}
+
+void Shader::BeginReload(const ShaderProgramSource& source)
+{
+    /* A reload that is still compiling is superseded by the newer source */
+    if (m_Reload.program != 0)
+    {
+        glDeleteShader(m_Reload.vertex);
+        glDeleteShader(m_Reload.fragment);
+        glDeleteProgram(m_Reload.program);
+    }
+    m_Reload = PendingProgram();
+    m_Dependencies = source.Dependencies;
+    CreateShader(source, m_Reload);
+}
+
+bool Shader::IsReloadReady() const
+{
+    return m_Reload.program != 0 && IsComplete(m_Reload);
+}
+
+bool Shader::FinishReload()
+{
+    if (m_Reload.program == 0)
+        return false;
+
+    Finish();
+    bool linked = CheckProgram(m_Reload);
+    if (linked)
+    {
+        /* Swap in the new program; cached locations belong to the old one */
+        GLCall(glDeleteProgram(m_RendererID));
+        m_RendererID = m_Reload.program;
+        m_UniformIndexCache.clear();
+        Reflect();
+    }
+    else
+    {
+        /* Keep running the old program */
+        std::cout << "Keeping previous version of " << m_FilePath << std::endl;
+        GLCall(glDeleteProgram(m_Reload.program));
+    }
+    m_Reload = PendingProgram();
+    return linked;
 }
 
 
@@ -143,36 +293,167 @@ void Shader::UnBind() const
 
 void Shader::SetUniform1i(const std::string& name, int value)
 {
-    GLCall(glUniform1i(GetUniformLocation(name), value));
+    SetUniform(UniformHandle{ GetUniformIndex(name) }, value);
 }
 
 void Shader::SetUniform1f(const std::string& name, float value)
 {
-    GLCall(glUniform1f(GetUniformLocation(name), value));
+    SetUniform(UniformHandle{ GetUniformIndex(name) }, value);
 }
 
 void Shader::SetUniform4f(const std::string& name, float v0, float v1, float v2, float v3)
 {
-    GLCall(glUniform4f(GetUniformLocation(name), v0, v1, v2, v3));
+    SetUniform(UniformHandle{ GetUniformIndex(name) }, glm::vec4(v0, v1, v2, v3));
 }
 
 void Shader::SetUniformMat4f(const std::string& name, const glm::mat4& matrix) {
 
-    GLCall(glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, &matrix[0][0])); // v means that we are passing an array   
+    SetUniform(UniformHandle{ GetUniformIndex(name) }, matrix);
+
+}
+
+/* GetUniformIndex() returns the index of a uniform in the reflection table,
+   or -1 if the program has no such active uniform */
+int Shader::GetUniformIndex(const std::string& name)
+{
+    auto it = m_UniformIndexCache.find(name);
+    if (it != m_UniformIndexCache.end())
+        return it->second;
+
+    int index = GetUniformHandle(name.c_str()).index;
+    m_UniformIndexCache.emplace(name, index);
+    return index; 
+}
+
+/* Reflect() enumerates the active uniforms and uniform blocks of the linked program.
+   Entries already in the table keep their index so existing handles stay valid */
+void Shader::Reflect()
+{
+    /* a new program starts with default values, so the shadow copies are stale */
+    for (UniformInfo& uniform : m_Uniforms)
+    {
+        uniform.location = -1;
+        uniform.shadowValid = false;
+    }
+    m_UniformBlocks.clear();
+
+    int linked = GL_FALSE;
+    GLCall(glGetProgramiv(m_RendererID, GL_LINK_STATUS, &linked));
+    if (linked == GL_FALSE)
+        return;
+
+    int count = 0, maxLength = 0;
+    /* glGetProgramiv() returns the number of active uniforms and their longest name */
+    GLCall(glGetProgramiv(m_RendererID, GL_ACTIVE_UNIFORMS, &count));
+    GLCall(glGetProgramiv(m_RendererID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength));
+    std::vector<char> buffer(maxLength > 0 ? maxLength : 1);
+    for (int i = 0; i < count; i++)
+    {
+        int length = 0, size = 0;
+        GLenum type = 0;
+        /* glGetActiveUniform() returns name, type and array size of the uniform at index [i] */
+        GLCall(glGetActiveUniform(m_RendererID, i, (GLsizei)buffer.size(), &length, &size, &type, buffer.data()));
+        std::string name(buffer.data(), length);
+        // arrays are reported as "name[0]"
+        if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+            name.resize(name.size() - 3);
+
+        /* members of uniform blocks have no location */
+        GLCall(int location = glGetUniformLocation(m_RendererID, name.c_str()));
+        if (location == -1)
+            continue;
+
+        auto it = std::find_if(m_Uniforms.begin(), m_Uniforms.end(),
+            [&name](const UniformInfo& uniform) { return uniform.name == name; });
+        if (it == m_Uniforms.end())
+            it = m_Uniforms.insert(m_Uniforms.end(), UniformInfo());
+        it->name = name;
+        it->location = location;
+        it->type = type;
+        it->size = size;
+        it->shadowValid = false;
+    }
+
+    count = 0;
+    GLCall(glGetProgramiv(m_RendererID, GL_ACTIVE_UNIFORM_BLOCKS, &count));
+    GLCall(glGetProgramiv(m_RendererID, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxLength));
+    buffer.resize(maxLength > 0 ? maxLength : 1);
+    for (int i = 0; i < count; i++)
+    {
+        int length = 0, dataSize = 0;
+        /* glGetActiveUniformBlockName() and glGetActiveUniformBlockiv() describe the block at index [i] */
+        GLCall(glGetActiveUniformBlockName(m_RendererID, i, (GLsizei)buffer.size(), &length, buffer.data()));
+        GLCall(glGetActiveUniformBlockiv(m_RendererID, i, GL_UNIFORM_BLOCK_DATA_SIZE, &dataSize));
+        m_UniformBlocks.push_back({ std::string(buffer.data(), length), (unsigned int)i, dataSize });
+    }
+}
+
+UniformHandle Shader::GetUniformHandle(const char* name)
+{
+    Finish();
+    UniformHandle handle;
+    for (unsigned int i = 0; i < m_Uniforms.size(); i++)
+    {
+        if (m_Uniforms[i].name == name)
+        {
+            handle.index = (int)i;
+            return handle;
+        }
+    }
+    std::cout << "Warning: uniform ' " << name << " ' doesn't exist " << std::endl;
+    return handle;
+}
+
+const UniformBlockInfo* Shader::FindUniformBlock(const char* name) const
+{
+    for (const UniformBlockInfo& block : m_UniformBlocks)
+    {
+        if (block.name == name)
+            return &block;
+    }
+    return nullptr;
+}
+
+/* UpdateShadow() compares [data] with the last uploaded value and records it,
+   returns false when the upload can be skipped */
+bool Shader::UpdateShadow(UniformHandle handle, const void* data, unsigned int size)
+{
+    UniformInfo& uniform = m_Uniforms[handle.index];
+    if (uniform.shadowValid && std::memcmp(uniform.shadow, data, size) == 0)
+    {
+        m_SkippedUploads++;
+        return false;
+    }
+    std::memcpy(uniform.shadow, data, size);
+    uniform.shadowValid = true;
+    return true;
+}
+
+/* Handle setters index the table directly and only reach the driver when the value changed */
+void Shader::SetUniform(UniformHandle handle, int value)
+{
+    if (!handle.IsValid() || !UpdateShadow(handle, &value, sizeof(value)))
+        return;
+    GLCall(glUniform1i(m_Uniforms[handle.index].location, value));
+}
 
+void Shader::SetUniform(UniformHandle handle, float value)
+{
+    if (!handle.IsValid() || !UpdateShadow(handle, &value, sizeof(value)))
+        return;
+    GLCall(glUniform1f(m_Uniforms[handle.index].location, value));
 }
 
-/* GetUniformLocation() returns an integer that represents the location
-   of a specific uniform variable within a program object */
-unsigned int Shader::GetUniformLocation(const std::string& name)
+void Shader::SetUniform(UniformHandle handle, const glm::vec4& value)
 {
-    if (m_UniformLocationCache.find(name) != m_UniformLocationCache.end())
-        return m_UniformLocationCache[name];
+    if (!handle.IsValid() || !UpdateShadow(handle, &value[0], sizeof(value)))
+        return;
+    GLCall(glUniform4fv(m_Uniforms[handle.index].location, 1, &value[0]));
+}
 
-    GLCall(unsigned int location = glGetUniformLocation(m_RendererID, name.c_str()));
-    if (location == -1)
-        std::cout << "Warning: uniform ' " << name << " ' doesn't exist " << std::endl;
-    
-    m_UniformLocationCache[name] = location;
-    return location; 
-}
\ No newline at end of file
+void Shader::SetUniform(UniformHandle handle, const glm::mat4& value)
+{
+    if (!handle.IsValid() || !UpdateShadow(handle, &value[0][0], sizeof(value)))
+        return;
+    GLCall(glUniformMatrix4fv(m_Uniforms[handle.index].location, 1, GL_FALSE, &value[0][0]));
+}
@@ -2,30 +2,123 @@
 
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include "ShaderPreprocessor.h"
 
 struct ShaderProgramSource
 {
 	std::string VertexSource;
 	std::string FragmentSource;
+	// the shader file and everything it #includes
+	std::vector<std::string> Dependencies;
+};
+
+class ProgramBinaryCache;
+
+/* A program submitted to the driver whose compile and link status hasn't been checked yet */
+struct PendingProgram
+{
+	unsigned int program = 0;
+	unsigned int vertex = 0;
+	unsigned int fragment = 0;
+	unsigned long long binaryKey = 0;
+};
+
+/* Active uniform of a linked program, filled by reflection after linking */
+struct UniformInfo
+{
+	std::string name;
+	int location;		// -1 if the uniform isn't active in the current program
+	unsigned int type;	// GL_FLOAT_VEC4, GL_SAMPLER_2D, ...
+	int size;			// array length, 1 for non-arrays
+
+	// last value uploaded to the first element, to skip redundant glUniform calls
+	alignas(16) unsigned char shadow[64];
+	bool shadowValid;
+};
+
+struct UniformBlockInfo
+{
+	std::string name;
+	unsigned int index;
+	int dataSize;
+};
+
+/* Index into a shader's uniform table, resolved once by name with GetUniformHandle()
+   and valid for the lifetime of the shader, hot reloads included */
+struct UniformHandle
+{
+	int index = -1;
+
+	inline bool IsValid() const { return index >= 0; }
 };
 
 class Shader
 {
 private: 
 	std::string m_FilePath;
+	ShaderDefines m_Defines;
+	std::vector<std::string> m_Dependencies;
 	
-	// caching for uniforms
-	std::unordered_map<std::string, unsigned int> m_UniformLocationCache;
+	// caching for uniforms, name to index in m_Uniforms
+	std::unordered_map<std::string, int> m_UniformIndexCache;
+	// glUniform calls skipped because the value was already set
+	unsigned long long m_SkippedUploads;
+
+	// reflection tables of the linked program
+	std::vector<UniformInfo> m_Uniforms;
+	std::vector<UniformBlockInfo> m_UniformBlocks;
+
+	// binary cache the program is loaded from and stored to
+	ProgramBinaryCache* m_BinaryCache;
+
+	// initial program until Finish(), and a hot reload still compiling
+	PendingProgram m_Pending;
+	PendingProgram m_Reload;
 
 public:
 	unsigned int m_RendererID;
 
-	Shader(const std::string& filepath);
+	/* With a [binaryCache] the linked program is loaded from / saved to disk.
+	   A [deferred] shader only submits compile and link; errors are checked by Finish().
+	   [defines] select a variant of the source, see ShaderPreprocessor */
+	Shader(const std::string& filepath, ProgramBinaryCache* binaryCache = nullptr, bool deferred = false,
+		const ShaderDefines& defines = ShaderDefines());
+	/* Builds the program from an already parsed [source], e.g. one compiled into the executable */
+	Shader(const std::string& name, const ShaderProgramSource& source, ProgramBinaryCache* binaryCache = nullptr,
+		bool deferred = false);
 	~Shader();
 
+	Shader(const Shader&) = delete;
+	Shader& operator=(const Shader&) = delete;
+
+	/* True once the driver is done compiling and linking, never blocks;
+	   always true without KHR_parallel_shader_compile, see CanPollCompletion() */
+	bool IsReady() const;
+	inline bool IsPending() const { return m_Pending.vertex != 0 || m_Pending.fragment != 0; }
+	/* Checks compile/link status and prints the logs, waits if the driver isn't done */
+	void Finish();
+
+	/* Hot reload: submits [source] to a new program next to the running one;
+	   FinishReload() swaps it in if it links, otherwise the old one keeps running */
+	void BeginReload(const ShaderProgramSource& source);
+	bool IsReloadReady() const;
+	bool FinishReload();
+
+	/* False when the driver can't report completion without waiting, then
+	   Finish() and FinishReload() may block until the link is done */
+	static bool CanPollCompletion();
+
+	inline const std::string& GetFilePath() const { return m_FilePath; }
+	inline const ShaderDefines& GetDefines() const { return m_Defines; }
+	inline const std::vector<std::string>& GetDependencies() const { return m_Dependencies; }
+
+	static ShaderProgramSource ParseShader(const std::string& filepath, const ShaderDefines& defines = ShaderDefines());
+	static ShaderProgramSource ParseEmbedded(const EmbeddedShader& shader, const ShaderDefines& defines = ShaderDefines());
+
 	void Bind() const; 
 	void UnBind() const; 
 
@@ -34,10 +127,28 @@ public:
 	void SetUniform1f(const std::string& name, float value); // e.g.
 	void SetUniform4f(const std::string& name, float v0, float v1, float v2, float v3);
 	void SetUniformMat4f(const std::string& name, const glm::mat4& matrix);
+
+	//Set uniforms through handles, no lookup per call
+	UniformHandle GetUniformHandle(const char* name);
+	void SetUniform(UniformHandle handle, int value);
+	void SetUniform(UniformHandle handle, float value);
+	void SetUniform(UniformHandle handle, const glm::vec4& value);
+	void SetUniform(UniformHandle handle, const glm::mat4& value);
+
+	inline const std::vector<UniformInfo>& GetUniforms() const { return m_Uniforms; }
+	inline const std::vector<UniformBlockInfo>& GetUniformBlocks() const { return m_UniformBlocks; }
+	const UniformBlockInfo* FindUniformBlock(const char* name) const;
+
+	inline unsigned long long GetSkippedUploads() const { return m_SkippedUploads; }
+	inline void ResetSkippedUploads() { m_SkippedUploads = 0; }
 	
 private:
-	ShaderProgramSource ParseShader(const std::string& filepath);
 	unsigned int CompileShader(unsigned int type, const std::string& source);
-	unsigned int CreateShader(const std::string& vertexShader, const std::string& fragmentShader);
-	unsigned int GetUniformLocation(const std::string& name);
+	bool CheckCompileStatus(unsigned int type, unsigned int id);
+	void CreateShader(const ShaderProgramSource& source, PendingProgram& pending);
+	bool CheckProgram(PendingProgram& pending);
+	static bool IsComplete(const PendingProgram& pending);
+	void Reflect();
+	int GetUniformIndex(const std::string& name);
+	bool UpdateShadow(UniformHandle handle, const void* data, unsigned int size);
 };
\ No newline at end of file
@@ -0,0 +1,174 @@
+#include "ShaderLibrary.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include "Renderer.h"
+#include "EmbeddedShaders.h"
+
+ShaderLibrary::ShaderLibrary(ProgramBinaryCache* binaryCache /*= nullptr*/)
+    : m_BinaryCache(binaryCache)
+{
+    /* glMaxShaderCompilerThreadsKHR() lets the driver use as many
+       compiler threads as it wants (0xFFFFFFFF means no limit) */
+    if (GLEW_KHR_parallel_shader_compile)
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+}
+
+void ShaderLibrary::LoadDirectory(const std::string& directory)
+{
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error))
+    {
+        if (entry.is_regular_file() && entry.path().extension() == ".shader")
+            Load(entry.path().generic_string());
+    }
+    if (error)
+        std::cout << "Warning: can't read shader directory ' " << directory << " ' " << std::endl;
+}
+
+Shader& ShaderLibrary::Load(const std::string& filepath)
+{
+    std::string name = std::filesystem::path(filepath).stem().string();
+    std::unique_ptr<Shader>& shader = m_Shaders[name];
+    m_Reloading.erase(std::remove(m_Reloading.begin(), m_Reloading.end(), shader.get()), m_Reloading.end());
+    m_Parsing.erase(shader.get());
+    m_Embedded.erase(name);
+    shader.reset(new Shader(filepath, m_BinaryCache, true));
+    return *shader;
+}
+
+void ShaderLibrary::LoadEmbedded()
+{
+    for (const EmbeddedShader& embedded : g_EmbeddedShaders)
+    {
+        std::unique_ptr<Shader>& shader = m_Shaders[embedded.name];
+        m_Reloading.erase(std::remove(m_Reloading.begin(), m_Reloading.end(), shader.get()), m_Reloading.end());
+        m_Parsing.erase(shader.get());
+        shader.reset(new Shader(embedded.name, Shader::ParseEmbedded(embedded), m_BinaryCache, true));
+        m_Embedded[embedded.name] = &embedded;
+    }
+}
+
+Shader& ShaderLibrary::Get(const std::string& name)
+{
+    auto it = m_Shaders.find(name);
+    if (it == m_Shaders.end())
+        std::cout << "Error: shader ' " << name << " ' isn't loaded " << std::endl;
+    ASSERT(it != m_Shaders.end());
+
+    it->second->Finish();
+    return *it->second;
+}
+
+bool ShaderLibrary::Exists(const std::string& name) const
+{
+    return m_Shaders.find(name) != m_Shaders.end();
+}
+
+Shader& ShaderLibrary::GetVariant(const std::string& name, const ShaderDefines& defines)
+{
+    if (defines.empty())
+        return Get(name);
+
+    std::string key = name + "#" + ShaderPreprocessor::GetDefinesKey(defines);
+    auto it = m_Variants.find(key);
+    if (it != m_Variants.end())
+        return *it->second;
+
+    Shader& base = Get(name);
+    std::unique_ptr<Shader>& variant = m_Variants[key];
+    auto embedded = m_Embedded.find(name);
+    if (embedded != m_Embedded.end())
+        variant.reset(new Shader(name, Shader::ParseEmbedded(*embedded->second, defines), m_BinaryCache));
+    else
+        variant.reset(new Shader(base.GetFilePath(), m_BinaryCache, false, defines));
+    return *variant;
+}
+
+unsigned int ShaderLibrary::Poll()
+{
+    /* without completion status every check may wait for the driver,
+       so only one shader is finished per call */
+    unsigned int budget = Shader::CanPollCompletion() ? (unsigned int)m_Shaders.size() : 1;
+    unsigned int pending = 0;
+    for (auto& entry : m_Shaders)
+    {
+        if (!entry.second->IsPending())
+            continue;
+        if (budget > 0 && entry.second->IsReady())
+        {
+            entry.second->Finish();
+            budget--;
+        }
+        else
+            pending++;
+    }
+    return pending;
+}
+
+void ShaderLibrary::EnableHotReload(const std::string& directory)
+{
+    m_Watcher.reset(new FileWatcher(directory));
+}
+
+std::vector<Shader*> ShaderLibrary::FindDependents(const std::string& filepath)
+{
+    std::string path = std::filesystem::path(filepath).lexically_normal().generic_string();
+    std::vector<Shader*> dependents;
+    for (auto* shaders : { &m_Shaders, &m_Variants })
+    {
+        for (auto& entry : *shaders)
+        {
+            const std::vector<std::string>& dependencies = entry.second->GetDependencies();
+            if (std::find(dependencies.begin(), dependencies.end(), path) != dependencies.end())
+                dependents.push_back(entry.second.get());
+        }
+    }
+    return dependents;
+}
+
+void ShaderLibrary::Update()
+{
+    if (!m_Watcher)
+        return;
+
+    /* 1. Shaders using a changed file are parsed again on a worker thread */
+    for (const std::string& path : m_Watcher->PollChanges())
+    {
+        for (Shader* shader : FindDependents(path))
+            m_Parsing[shader] = std::async(std::launch::async, &Shader::ParseShader, shader->GetFilePath(), shader->GetDefines());
+    }
+
+    /* 2. Parsed sources are submitted to the driver next to the running program */
+    for (auto it = m_Parsing.begin(); it != m_Parsing.end(); )
+    {
+        if (it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            ++it;
+            continue;
+        }
+        Shader* shader = it->first;
+        shader->BeginReload(it->second.get());
+        if (std::find(m_Reloading.begin(), m_Reloading.end(), shader) == m_Reloading.end())
+            m_Reloading.push_back(shader);
+        it = m_Parsing.erase(it);
+    }
+
+    /* 3. Finished programs are swapped in, failed ones are dropped; one per
+       call when checking may wait for the driver, as in Poll() */
+    unsigned int budget = Shader::CanPollCompletion() ? (unsigned int)m_Reloading.size() : 1;
+    for (auto it = m_Reloading.begin(); it != m_Reloading.end(); )
+    {
+        if (budget == 0 || !(*it)->IsReloadReady())
+        {
+            ++it;
+            continue;
+        }
+        budget--;
+        if ((*it)->FinishReload())
+            std::cout << "Reloaded " << (*it)->GetFilePath() << std::endl;
+        it = m_Reloading.erase(it);
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "Shader.h"
+#include "FileWatcher.h"
+
+class ProgramBinaryCache;
+
+/* Owns the shaders of the application by name (file name without extension).
+   Every shader is submitted to the driver up front and only checked for
+   errors the first time it is asked for, so the driver can compile them all
+   in parallel instead of blocking on each one. */
+class ShaderLibrary
+{
+private:
+	std::unordered_map<std::string, std::unique_ptr<Shader>> m_Shaders;
+	// permutations keyed by "name#defines", each compiled once on first request
+	std::unordered_map<std::string, std::unique_ptr<Shader>> m_Variants;
+	ProgramBinaryCache* m_BinaryCache;
+	// shaders loaded from the executable instead of a file
+	std::unordered_map<std::string, const EmbeddedShader*> m_Embedded;
+
+	// hot reload: watched directory and sources being parsed in the background
+	std::unique_ptr<FileWatcher> m_Watcher;
+	std::unordered_map<Shader*, std::future<ShaderProgramSource>> m_Parsing;
+	std::vector<Shader*> m_Reloading;
+
+	/* Shaders and variants built from [filepath] or including it */
+	std::vector<Shader*> FindDependents(const std::string& filepath);
+public:
+	ShaderLibrary(ProgramBinaryCache* binaryCache = nullptr);
+
+	/* Submits every .shader file in [directory] */
+	void LoadDirectory(const std::string& directory);
+	/* Submits a single shader file, replacing any shader with the same name */
+	Shader& Load(const std::string& filepath);
+	/* Submits the shaders compiled into the executable (EmbeddedShaders.h) */
+	void LoadEmbedded();
+
+	/* Returns the shader named [name], waiting for its link to finish if needed */
+	Shader& Get(const std::string& name);
+	bool Exists(const std::string& name) const;
+
+	/* Returns the permutation of shader [name] compiled with [defines],
+	   compiling it the first time this define set is asked for */
+	Shader& GetVariant(const std::string& name, const ShaderDefines& defines);
+
+	/* Finishes the shaders the driver is already done with and returns how
+	   many are still compiling. Never blocks with KHR_parallel_shader_compile;
+	   without it completion can't be queried, so one shader is finished per
+	   call and that call may wait for its link */
+	unsigned int Poll();
+
+	/* Watches [directory] and recompiles shaders whose file or includes change */
+	void EnableHotReload(const std::string& directory);
+	/* Drives hot reloads, call once per frame on the GL thread. Never blocks
+	   with KHR_parallel_shader_compile, otherwise at most one reload per call
+	   waits for its link, as in Poll() */
+	void Update();
+};
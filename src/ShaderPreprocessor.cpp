@@ -0,0 +1,154 @@
+#include "ShaderPreprocessor.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include "Hash.h"
+
+/* Deepest #include nesting accepted before assuming a cycle */
+#define MAX_INCLUDE_DEPTH 16
+
+/* Pops the next line off [text], without its line terminator */
+static std::string_view NextLine(std::string_view& text)
+{
+    size_t end = text.find('\n');
+    std::string_view line = text.substr(0, end);
+    text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+    if (!line.empty() && line.back() == '\r')
+        line.remove_suffix(1);
+    return line;
+}
+
+/* [included] holds the files already expanded into the current stage */
+static bool ResolveFile(const std::filesystem::path& path, std::vector<std::string>& dependencies,
+    std::vector<unsigned long long>* hashes, std::vector<std::string>& included, std::string& out, int depth)
+{
+    std::string filepath = path.lexically_normal().generic_string();
+    /* included files behave as if they had #pragma once, per stage */
+    if (std::find(included.begin(), included.end(), filepath) != included.end())
+        return true;
+    if (depth > MAX_INCLUDE_DEPTH)
+    {
+        std::cout << "Error: #include nested too deep in ' " << filepath << " ' " << std::endl;
+        return false;
+    }
+
+    std::string contents;
+    if (!ShaderPreprocessor::ReadFile(filepath, contents))
+    {
+        std::cout << "Error: can't open shader file ' " << filepath << " ' " << std::endl;
+        return false;
+    }
+    included.push_back(filepath);
+    if (std::find(dependencies.begin(), dependencies.end(), filepath) == dependencies.end())
+    {
+        dependencies.push_back(filepath);
+        if (hashes)
+            hashes->push_back(HashBytes(contents.data(), contents.size()));
+    }
+    out.reserve(out.size() + contents.size());
+
+    std::string_view text(contents);
+    while (!text.empty())
+    {
+        std::string_view line = NextLine(text);
+        /* every stage is compiled on its own, so it gets its own copy of a
+           file the previous stage included already; the shader file stays */
+        if (line.find("#shader") != std::string_view::npos)
+            included.resize(1);
+        /* #include "file" */
+        size_t directive = line.find("#include");
+        if (directive != std::string_view::npos && line.find_first_not_of(" \t") == directive)
+        {
+            size_t begin = line.find('"', directive);
+            size_t end = begin == std::string_view::npos ? begin : line.find('"', begin + 1);
+            if (end == std::string_view::npos)
+            {
+                std::cout << "Error: malformed #include in ' " << filepath << " ': " << line << std::endl;
+                return false;
+            }
+            std::string_view name = line.substr(begin + 1, end - begin - 1);
+            if (!ResolveFile(path.parent_path() / name, dependencies, hashes, included, out, depth + 1))
+                return false;
+            continue;
+        }
+        out.append(line);
+        out.push_back('\n');
+    }
+    return true;
+}
+
+bool ShaderPreprocessor::ReadFile(const std::string& filepath, std::string& contents)
+{
+    std::ifstream stream(filepath, std::ios::binary | std::ios::ate);
+    if (!stream)
+        return false;
+    std::streamsize size = stream.tellg();
+    if (size < 0)
+        return false;
+    stream.seekg(0);
+    contents.resize((size_t)size);
+    return (bool)stream.read(&contents[0], size);
+}
+
+std::string ShaderPreprocessor::ResolveIncludes(const std::string& filepath, std::vector<std::string>& dependencies,
+    std::vector<unsigned long long>* hashes /*= nullptr*/)
+{
+    std::string out;
+    std::vector<std::string> included;
+    ResolveFile(filepath, dependencies, hashes, included, out, 0);
+    return out;
+}
+
+void ShaderPreprocessor::SplitStages(std::string_view source, std::string& vertex, std::string& fragment)
+{
+    std::string* stage = nullptr;
+    /* go line by line and find the beginning of each shader */
+    while (!source.empty())
+    {
+        std::string_view line = NextLine(source);
+        if (line.find("#shader") != std::string_view::npos)
+        {
+            if (line.find("vertex") != std::string_view::npos)
+                stage = &vertex;
+            else if (line.find("fragment") != std::string_view::npos)
+                stage = &fragment;
+        }
+        else if (stage)
+        {
+            stage->append(line);
+            stage->push_back('\n');
+        }
+    }
+}
+
+std::string ShaderPreprocessor::InjectDefines(const std::string& source, const ShaderDefines& defines)
+{
+    if (defines.empty())
+        return source;
+
+    std::string block;
+    for (const auto& define : defines)
+        block += "#define " + define.first + " " + define.second + "\n";
+
+    /* #version has to stay the first directive of the stage */
+    size_t version = source.find("#version");
+    if (version == std::string::npos)
+        return block + source;
+    size_t lineEnd = source.find('\n', version);
+    if (lineEnd == std::string::npos)
+        return source + "\n" + block;
+    return source.substr(0, lineEnd + 1) + block + source.substr(lineEnd + 1);
+}
+
+std::string ShaderPreprocessor::GetDefinesKey(const ShaderDefines& defines)
+{
+    ShaderDefines sorted = defines;
+    std::sort(sorted.begin(), sorted.end());
+
+    std::string key;
+    for (const auto& define : sorted)
+        key += define.first + "=" + define.second + ";";
+    return key;
+}
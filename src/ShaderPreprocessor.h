@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/* (name, value) pairs injected as #define into every stage of a shader variant */
+typedef std::vector<std::pair<std::string, std::string>> ShaderDefines;
+
+/* A shader compiled into the executable, already preprocessed and split into stages */
+struct EmbeddedShader
+{
+	const char* name;
+	std::string_view vertex;
+	std::string_view fragment;
+};
+
+class ShaderPreprocessor
+{
+public:
+	/* Reads a whole file with a single read, false if it can't be opened */
+	static bool ReadFile(const std::string& filepath, std::string& contents);
+
+	/* Reads [filepath] and expands #include "file" directives, resolved relative to
+	   the including file; each file is included once per "#shader" stage. Every
+	   file read is appended to [dependencies] once, and when [hashes] is given
+	   the content hash of what was read goes to the same position in it */
+	static std::string ResolveIncludes(const std::string& filepath, std::vector<std::string>& dependencies,
+		std::vector<unsigned long long>* hashes = nullptr);
+
+	/* Splits a .shader file at its "#shader vertex" / "#shader fragment" markers */
+	static void SplitStages(std::string_view source, std::string& vertex, std::string& fragment);
+
+	/* Inserts [defines] right after the #version line of a stage */
+	static std::string InjectDefines(const std::string& source, const ShaderDefines& defines);
+
+	/* Canonical text of a define set, equal for equal sets in any order */
+	static std::string GetDefinesKey(const ShaderDefines& defines);
+};
@@ -0,0 +1,19 @@
+#pragma once
+
+/* Instruction sets the SIMD kernels are compiled for, picked at compile time:
+   SIMD_AVX2 with /arch:AVX2 (-mavx2), SIMD_SSE2 on any x64 build.
+   Kernels keep a scalar path for everything else. */
+#if defined(__AVX2__)
+	#define SIMD_AVX2 1
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define SIMD_SSE2 1
+#endif
+
+#if defined(SIMD_AVX2)
+	#include <immintrin.h>
+#elif defined(SIMD_SSE2)
+	#include <emmintrin.h>
+	#include <xmmintrin.h>
+#endif
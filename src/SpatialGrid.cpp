@@ -0,0 +1,196 @@
+#include "SpatialGrid.h"
+
+#include <cassert>
+#include <cmath>
+#include "Frustum.h"
+
+static inline bool Overlaps(const AABB& a, const AABB& b)
+{
+    return a.min.x <= b.max.x && a.max.x >= b.min.x
+        && a.min.y <= b.max.y && a.max.y >= b.min.y
+        && a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+SpatialGrid::SpatialGrid(float cellSize)
+    : m_CellSize(cellSize), m_InverseCellSize(1.0f / cellSize), m_MaxExtents(0.0f)
+{
+}
+
+glm::ivec3 SpatialGrid::GetCellCoord(const glm::vec3& position) const
+{
+    glm::vec3 cell = glm::floor(position * m_InverseCellSize);
+    return glm::ivec3(cell);
+}
+
+/* 21 bits per axis, enough for a million cells in every direction */
+uint64_t SpatialGrid::GetCellKey(const glm::ivec3& coord)
+{
+    const uint64_t mask = (1ull << 21) - 1;
+    return ((uint64_t)coord.x & mask) | (((uint64_t)coord.y & mask) << 21) | (((uint64_t)coord.z & mask) << 42);
+}
+
+void SpatialGrid::Link(unsigned int object, uint64_t key, const glm::ivec3& coord)
+{
+    Cell& cell = m_Cells[key];
+    if (cell.objects.empty())
+        cell.coord = coord;
+    m_Entries[object].cell = key;
+    m_Entries[object].slot = (unsigned int)cell.objects.size();
+    cell.objects.push_back(object);
+}
+
+void SpatialGrid::Unlink(unsigned int object)
+{
+    Entry& entry = m_Entries[object];
+    auto it = m_Cells.find(entry.cell);
+    std::vector<unsigned int>& objects = it->second.objects;
+
+    /* swap with the last object of the cell so removal stays O(1) */
+    unsigned int last = objects.back();
+    objects[entry.slot] = last;
+    m_Entries[last].slot = entry.slot;
+    objects.pop_back();
+    if (objects.empty())
+        m_Cells.erase(it);
+}
+
+unsigned int SpatialGrid::Insert(const AABB& bounds)
+{
+    unsigned int object;
+    if (!m_FreeList.empty())
+    {
+        object = m_FreeList.back();
+        m_FreeList.pop_back();
+    }
+    else
+    {
+        object = (unsigned int)m_Entries.size();
+        m_Entries.emplace_back();
+    }
+
+    Entry& entry = m_Entries[object];
+    entry.bounds = bounds;
+    entry.alive = true;
+    m_MaxExtents = glm::max(m_MaxExtents, bounds.GetExtents());
+
+    glm::ivec3 coord = GetCellCoord(bounds.GetCenter());
+    Link(object, GetCellKey(coord), coord);
+    return object;
+}
+
+void SpatialGrid::Update(unsigned int object, const AABB& bounds)
+{
+    /* a removed handle has no cell to unlink from; plain assert, the grid
+       is used by the GL-free tools as well */
+    assert(object < m_Entries.size() && m_Entries[object].alive);
+    if (object >= m_Entries.size() || !m_Entries[object].alive)
+        return;
+    Entry& entry = m_Entries[object];
+    entry.bounds = bounds;
+    /* the query margin only ever grows, it is reset by Clear() */
+    m_MaxExtents = glm::max(m_MaxExtents, bounds.GetExtents());
+
+    glm::ivec3 coord = GetCellCoord(bounds.GetCenter());
+    uint64_t key = GetCellKey(coord);
+    if (key == entry.cell)
+        return;
+    Unlink(object);
+    Link(object, key, coord);
+}
+
+void SpatialGrid::Remove(unsigned int object)
+{
+    if (!m_Entries[object].alive)
+        return;
+    Unlink(object);
+    m_Entries[object].alive = false;
+    m_FreeList.push_back(object);
+}
+
+void SpatialGrid::Clear()
+{
+    m_Cells.clear();
+    m_Entries.clear();
+    m_FreeList.clear();
+    m_MaxExtents = glm::vec3(0.0f);
+}
+
+void SpatialGrid::Query(const AABB& box, std::vector<unsigned int>& result) const
+{
+    result.clear();
+    glm::ivec3 first = GetCellCoord(box.min - m_MaxExtents);
+    glm::ivec3 last = GetCellCoord(box.max + m_MaxExtents);
+    glm::ivec3 range = last - first + glm::ivec3(1);
+
+    /* a box covering more cells than are occupied is cheaper to answer
+       by walking the occupied cells than by probing every coordinate */
+    if ((double)range.x * range.y * range.z > (double)m_Cells.size())
+    {
+        for (const auto& pair : m_Cells)
+        {
+            const Cell& cell = pair.second;
+            if (glm::any(glm::lessThan(cell.coord, first)) || glm::any(glm::greaterThan(cell.coord, last)))
+                continue;
+            for (unsigned int object : cell.objects)
+            {
+                if (Overlaps(m_Entries[object].bounds, box))
+                    result.push_back(object);
+            }
+        }
+        return;
+    }
+
+    for (int z = first.z; z <= last.z; z++)
+    {
+        for (int y = first.y; y <= last.y; y++)
+        {
+            for (int x = first.x; x <= last.x; x++)
+            {
+                auto it = m_Cells.find(GetCellKey(glm::ivec3(x, y, z)));
+                if (it == m_Cells.end())
+                    continue;
+                for (unsigned int object : it->second.objects)
+                {
+                    if (Overlaps(m_Entries[object].bounds, box))
+                        result.push_back(object);
+                }
+            }
+        }
+    }
+}
+
+void SpatialGrid::Query(const Frustum& frustum, std::vector<unsigned int>& result) const
+{
+    result.clear();
+    for (const auto& pair : m_Cells)
+    {
+        const Cell& cell = pair.second;
+        /* loose bounds of the cell: every object centered in it fits inside */
+        glm::vec3 cellMin = glm::vec3(cell.coord) * m_CellSize;
+        AABB looseBounds = { cellMin - m_MaxExtents, cellMin + glm::vec3(m_CellSize) + m_MaxExtents };
+        if (!frustum.Intersects(looseBounds))
+            continue;
+        for (unsigned int object : cell.objects)
+        {
+            if (frustum.Intersects(m_Entries[object].bounds))
+                result.push_back(object);
+        }
+    }
+}
+
+void SpatialGrid::QueryRadius(const glm::vec3& center, float radius, std::vector<unsigned int>& result) const
+{
+    Query(AABB{ center - glm::vec3(radius), center + glm::vec3(radius) }, result);
+
+    /* keep the objects whose closest point is really within the sphere */
+    unsigned int kept = 0;
+    for (unsigned int object : result)
+    {
+        const AABB& bounds = m_Entries[object].bounds;
+        glm::vec3 closest = glm::clamp(center, bounds.min, bounds.max);
+        glm::vec3 offset = closest - center;
+        if (glm::dot(offset, offset) <= radius * radius)
+            result[kept++] = object;
+    }
+    result.resize(kept);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Bounds.h"
+
+class Frustum;
+
+/* Loose uniform grid, hashed so only occupied cells take memory.
+   An object lives in the single cell containing the center of its bounds,
+   queries widen their cell range by the largest object extent to catch
+   objects hanging over a cell border. Insert, Update and Remove are O(1),
+   which suits scenes where most objects move every frame and a BVH would
+   spend its time refitting. */
+class SpatialGrid
+{
+private:
+	struct Cell
+	{
+		glm::ivec3 coord;
+		std::vector<unsigned int> objects;
+	};
+
+	struct Entry
+	{
+		AABB bounds;
+		uint64_t cell;		// key of the cell the object lives in
+		unsigned int slot;	// position inside that cell's object list
+		bool alive;
+	};
+
+	float m_CellSize;
+	float m_InverseCellSize;
+	std::unordered_map<uint64_t, Cell> m_Cells;
+	std::vector<Entry> m_Entries;
+	std::vector<unsigned int> m_FreeList;
+	glm::vec3 m_MaxExtents;
+
+	glm::ivec3 GetCellCoord(const glm::vec3& position) const;
+	static uint64_t GetCellKey(const glm::ivec3& coord);
+	void Link(unsigned int object, uint64_t key, const glm::ivec3& coord);
+	void Unlink(unsigned int object);
+public:
+	/* [cellSize] should be around the size of a typical object */
+	SpatialGrid(float cellSize);
+
+	/* Returns the object handle, handles of removed objects get reused */
+	unsigned int Insert(const AABB& bounds);
+	/* Moves [object] to its new bounds, only touches the cell lists when it crossed a cell;
+	   [object] must not have been removed */
+	void Update(unsigned int object, const AABB& bounds);
+	void Remove(unsigned int object);
+	void Clear();
+
+	/* Objects overlapping [box] */
+	void Query(const AABB& box, std::vector<unsigned int>& result) const;
+	/* Objects touching [frustum], tested cell by cell before the objects of the cell */
+	void Query(const Frustum& frustum, std::vector<unsigned int>& result) const;
+	/* Objects whose bounds come within [radius] of [center] */
+	void QueryRadius(const glm::vec3& center, float radius, std::vector<unsigned int>& result) const;
+
+	inline const AABB& GetBounds(unsigned int object) const { return m_Entries[object].bounds; }
+	inline unsigned int GetCellCount() const { return (unsigned int)m_Cells.size(); }
+	inline float GetCellSize() const { return m_CellSize; }
+};
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+/* Coroutine result, started as soon as it is called (C++20).
+   The body runs on the calling thread up to its first suspension, so
+   starting several tasks and only then awaiting them runs them
+   concurrently. Awaiting a finished task doesn't suspend; awaiting a
+   running one resumes the awaiter on the thread that finishes it.
+   A task may be dropped without being awaited, the frame frees itself. */
+template<typename T>
+class Task;
+
+namespace detail {
+
+/* Marks the continuation slot of a finished task */
+inline void* TaskDone() { static char done; return &done; }
+
+struct TaskPromiseBase
+{
+	std::atomic<void*> continuation{ nullptr };
+	std::atomic<int> references{ 2 };	// the Task object and the running coroutine
+
+	std::suspend_never initial_suspend() noexcept { return {}; }
+
+	struct FinalAwaiter
+	{
+		bool await_ready() noexcept { return false; }
+		template<typename Promise>
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+		{
+			TaskPromiseBase& promise = handle.promise();
+			void* waiting = promise.continuation.exchange(TaskDone(), std::memory_order_acq_rel);
+			std::coroutine_handle<> next = waiting ? std::coroutine_handle<>::from_address(waiting) : std::noop_coroutine();
+			/* the frame lives on until the Task object lets go of it too */
+			if (promise.references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				handle.destroy();
+			return next;
+		}
+		void await_resume() noexcept {}
+	};
+	FinalAwaiter final_suspend() noexcept { return {}; }
+
+	/* the code base doesn't use exceptions, a throwing loader is a bug */
+	void unhandled_exception() { std::terminate(); }
+
+	inline bool IsDone() const { return continuation.load(std::memory_order_acquire) == TaskDone(); }
+	/* False when the task already finished and [awaiting] should just carry on */
+	inline bool SetContinuation(std::coroutine_handle<> awaiting)
+	{
+		void* expected = nullptr;
+		return continuation.compare_exchange_strong(expected, awaiting.address(), std::memory_order_acq_rel);
+	}
+};
+
+template<typename T>
+struct TaskPromise : TaskPromiseBase
+{
+	std::optional<T> value;
+
+	Task<T> get_return_object();
+	template<typename U>
+	void return_value(U&& result) { value.emplace(std::forward<U>(result)); }
+	T TakeResult() { return std::move(*value); }
+};
+
+template<>
+struct TaskPromise<void> : TaskPromiseBase
+{
+	Task<void> get_return_object();
+	void return_void() {}
+	void TakeResult() {}
+};
+
+}
+
+template<typename T>
+class Task
+{
+public:
+	typedef detail::TaskPromise<T> promise_type;
+private:
+	std::coroutine_handle<promise_type> m_Handle;
+
+	void Release()
+	{
+		if (m_Handle && m_Handle.promise().references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			m_Handle.destroy();
+		m_Handle = nullptr;
+	}
+public:
+	explicit Task(std::coroutine_handle<promise_type> handle)
+		: m_Handle(handle) {}
+	Task(Task&& other) noexcept
+		: m_Handle(std::exchange(other.m_Handle, nullptr)) {}
+	Task& operator=(Task&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Release();
+			m_Handle = std::exchange(other.m_Handle, nullptr);
+		}
+		return *this;
+	}
+	Task(const Task&) = delete;
+	Task& operator=(const Task&) = delete;
+	~Task() { Release(); }
+
+	inline bool IsReady() const { return m_Handle && m_Handle.promise().IsDone(); }
+	/* Result of a finished task, moved out; call once */
+	T GetResult() { return m_Handle.promise().TakeResult(); }
+
+	struct Awaiter
+	{
+		std::coroutine_handle<promise_type> handle;
+
+		bool await_ready() const noexcept { return handle.promise().IsDone(); }
+		bool await_suspend(std::coroutine_handle<> awaiting) noexcept { return handle.promise().SetContinuation(awaiting); }
+		T await_resume() { return handle.promise().TakeResult(); }
+	};
+	Awaiter operator co_await() & noexcept { return Awaiter{ m_Handle }; }
+	Awaiter operator co_await() && noexcept { return Awaiter{ m_Handle }; }
+};
+
+namespace detail {
+
+template<typename T>
+inline Task<T> TaskPromise<T>::get_return_object() { return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this)); }
+
+inline Task<void> TaskPromise<void>::get_return_object() { return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this)); }
+
+}
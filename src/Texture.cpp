@@ -7,6 +7,20 @@ Texture::Texture(const std::string& path)
 	stbi_set_flip_vertically_on_load(1);
 	m_LocalBuffer = stbi_load(path.c_str(), &m_Width, &m_Height, &m_BPP, 4); //4 channels, recommended for PNG
 
+	Upload(m_LocalBuffer);
+
+	if (m_LocalBuffer)
+		stbi_image_free(m_LocalBuffer);
+}
+
+Texture::Texture(const unsigned char* pixels, int width, int height)
+	: m_LocalBuffer(nullptr), m_Width(width), m_Height(height), m_BPP(4)
+{
+	Upload(pixels);
+}
+
+void Texture::Upload(const unsigned char* pixels)
+{
 	/* glGenTextures() generates a texture name in [m_RendererID] */
 	GLCall(glGenTextures(1, &m_RendererID));
 	/* glBindTexture() binds a texture named [m_RendererID]
@@ -18,11 +32,8 @@ Texture::Texture(const std::string& path)
 	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
 	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
 	/* glTexImage2D() specifies a two-dimensional texture image */
-	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_Width, m_Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_LocalBuffer ));
+	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_Width, m_Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
 	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
-
-	if (m_LocalBuffer)
-		stbi_image_free(m_LocalBuffer);
 }
 
 Texture::~Texture()
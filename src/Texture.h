@@ -9,8 +9,12 @@ private:
 	std::string m_FilePath;
 	unsigned char* m_LocalBuffer;
 	int m_Width, m_Height, m_BPP;
+
+	void Upload(const unsigned char* pixels);
 public:
 	Texture(const std::string& path);
+	/* Texture from already decoded RGBA8 [pixels], e.g. decoded by a loader thread */
+	Texture(const unsigned char* pixels, int width, int height);
 	~Texture();
 
 	void Bind(unsigned int slot = 0) const;
@@ -0,0 +1,186 @@
+#include "TransformSystem.h"
+
+#include "Simd.h"
+
+/* Pointers into the component arrays, shared by the scalar and SIMD kernels */
+struct TransformArrays
+{
+    const float* px; const float* py; const float* pz;
+    const float* rx; const float* ry; const float* rz; const float* rw;
+    const float* sx; const float* sy; const float* sz;
+};
+
+#if defined(SIMD_SSE2) || defined(SIMD_AVX2)
+
+/* Transposes four lanes of column [column] (one vector per row) and
+   writes them into the matrices of four consecutive objects */
+static inline void StoreColumn4(__m128 r0, __m128 r1, __m128 r2, __m128 r3, glm::mat4* out, int column)
+{
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    _mm_storeu_ps(&out[0][column][0], r0);
+    _mm_storeu_ps(&out[1][column][0], r1);
+    _mm_storeu_ps(&out[2][column][0], r2);
+    _mm_storeu_ps(&out[3][column][0], r3);
+}
+
+/* Lane traits: the kernel below is written once for 4-wide SSE and 8-wide AVX2 */
+struct Float4
+{
+    typedef __m128 V;
+    static const unsigned int Width = 4;
+    static inline V Load(const float* p) { return _mm_loadu_ps(p); }
+    static inline V Set(float f) { return _mm_set1_ps(f); }
+    static inline V Add(V a, V b) { return _mm_add_ps(a, b); }
+    static inline V Sub(V a, V b) { return _mm_sub_ps(a, b); }
+    static inline V Mul(V a, V b) { return _mm_mul_ps(a, b); }
+    static inline void StoreColumn(V r0, V r1, V r2, V r3, glm::mat4* out, int column)
+    {
+        StoreColumn4(r0, r1, r2, r3, out, column);
+    }
+};
+
+#if defined(SIMD_AVX2)
+struct Float8
+{
+    typedef __m256 V;
+    static const unsigned int Width = 8;
+    static inline V Load(const float* p) { return _mm256_loadu_ps(p); }
+    static inline V Set(float f) { return _mm256_set1_ps(f); }
+    static inline V Add(V a, V b) { return _mm256_add_ps(a, b); }
+    static inline V Sub(V a, V b) { return _mm256_sub_ps(a, b); }
+    static inline V Mul(V a, V b) { return _mm256_mul_ps(a, b); }
+    static inline void StoreColumn(V r0, V r1, V r2, V r3, glm::mat4* out, int column)
+    {
+        StoreColumn4(_mm256_castps256_ps128(r0), _mm256_castps256_ps128(r1),
+                     _mm256_castps256_ps128(r2), _mm256_castps256_ps128(r3), out, column);
+        StoreColumn4(_mm256_extractf128_ps(r0, 1), _mm256_extractf128_ps(r1, 1),
+                     _mm256_extractf128_ps(r2, 1), _mm256_extractf128_ps(r3, 1), out + 4, column);
+    }
+};
+#endif
+
+/* Composes S::Width objects starting at [i]: rotation matrix from the quaternion,
+   scaled columns, translation, then the product with the view projection */
+template<typename S>
+static void ComposeBatch(const TransformArrays& a, unsigned int i, const glm::mat4& vp, glm::mat4* world, glm::mat4* mvp)
+{
+    typedef typename S::V V;
+    const V one = S::Set(1.0f), two = S::Set(2.0f), zero = S::Set(0.0f);
+
+    V x = S::Load(a.rx + i), y = S::Load(a.ry + i), z = S::Load(a.rz + i), w = S::Load(a.rw + i);
+    V xx = S::Mul(x, x), yy = S::Mul(y, y), zz = S::Mul(z, z);
+    V xy = S::Mul(x, y), xz = S::Mul(x, z), yz = S::Mul(y, z);
+    V wx = S::Mul(w, x), wy = S::Mul(w, y), wz = S::Mul(w, z);
+
+    V sx = S::Load(a.sx + i), sy = S::Load(a.sy + i), sz = S::Load(a.sz + i);
+
+    /* same layout as glm::mat3_cast, each column scaled by its axis scale */
+    V m[4][4];
+    m[0][0] = S::Mul(S::Sub(one, S::Mul(two, S::Add(yy, zz))), sx);
+    m[0][1] = S::Mul(S::Mul(two, S::Add(xy, wz)), sx);
+    m[0][2] = S::Mul(S::Mul(two, S::Sub(xz, wy)), sx);
+    m[0][3] = zero;
+    m[1][0] = S::Mul(S::Mul(two, S::Sub(xy, wz)), sy);
+    m[1][1] = S::Mul(S::Sub(one, S::Mul(two, S::Add(xx, zz))), sy);
+    m[1][2] = S::Mul(S::Mul(two, S::Add(yz, wx)), sy);
+    m[1][3] = zero;
+    m[2][0] = S::Mul(S::Mul(two, S::Add(xz, wy)), sz);
+    m[2][1] = S::Mul(S::Mul(two, S::Sub(yz, wx)), sz);
+    m[2][2] = S::Mul(S::Sub(one, S::Mul(two, S::Add(xx, yy))), sz);
+    m[2][3] = zero;
+    m[3][0] = S::Load(a.px + i);
+    m[3][1] = S::Load(a.py + i);
+    m[3][2] = S::Load(a.pz + i);
+    m[3][3] = one;
+
+    for (int c = 0; c < 4; c++)
+        S::StoreColumn(m[c][0], m[c][1], m[c][2], m[c][3], world + i, c);
+
+    /* mvp[c][r] = sum_k vp[k][r] * world[c][k]; world[c][3] is 0 or 1 so the
+       last term is dropped for the first three columns */
+    for (int c = 0; c < 4; c++)
+    {
+        V r[4];
+        for (int row = 0; row < 4; row++)
+        {
+            V sum = S::Add(S::Add(S::Mul(S::Set(vp[0][row]), m[c][0]),
+                                  S::Mul(S::Set(vp[1][row]), m[c][1])),
+                                  S::Mul(S::Set(vp[2][row]), m[c][2]));
+            r[row] = c == 3 ? S::Add(sum, S::Set(vp[3][row])) : sum;
+        }
+        S::StoreColumn(r[0], r[1], r[2], r[3], mvp + i, c);
+    }
+}
+
+#endif
+
+unsigned int TransformSystem::Create(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+{
+    unsigned int index = GetCount();
+    m_PositionX.push_back(position.x); m_PositionY.push_back(position.y); m_PositionZ.push_back(position.z);
+    m_RotationX.push_back(rotation.x); m_RotationY.push_back(rotation.y); m_RotationZ.push_back(rotation.z); m_RotationW.push_back(rotation.w);
+    m_ScaleX.push_back(scale.x); m_ScaleY.push_back(scale.y); m_ScaleZ.push_back(scale.z);
+    m_World.emplace_back(1.0f);
+    m_MVP.emplace_back(1.0f);
+    return index;
+}
+
+void TransformSystem::SetPosition(unsigned int index, const glm::vec3& position)
+{
+    m_PositionX[index] = position.x;
+    m_PositionY[index] = position.y;
+    m_PositionZ[index] = position.z;
+}
+
+void TransformSystem::SetRotation(unsigned int index, const glm::quat& rotation)
+{
+    m_RotationX[index] = rotation.x;
+    m_RotationY[index] = rotation.y;
+    m_RotationZ[index] = rotation.z;
+    m_RotationW[index] = rotation.w;
+}
+
+void TransformSystem::SetScale(unsigned int index, const glm::vec3& scale)
+{
+    m_ScaleX[index] = scale.x;
+    m_ScaleY[index] = scale.y;
+    m_ScaleZ[index] = scale.z;
+}
+
+/* Reference path, used for the objects left over after the SIMD batches */
+void TransformSystem::ComposeScalar(unsigned int begin, unsigned int end, const glm::mat4& viewProjection)
+{
+    for (unsigned int i = begin; i < end; i++)
+    {
+        glm::quat rotation(m_RotationW[i], m_RotationX[i], m_RotationY[i], m_RotationZ[i]);
+        glm::mat4 world = glm::mat4_cast(rotation);
+        world[0] *= m_ScaleX[i];
+        world[1] *= m_ScaleY[i];
+        world[2] *= m_ScaleZ[i];
+        world[3] = glm::vec4(m_PositionX[i], m_PositionY[i], m_PositionZ[i], 1.0f);
+        m_World[i] = world;
+        m_MVP[i] = viewProjection * world;
+    }
+}
+
+void TransformSystem::Update(const glm::mat4& viewProjection)
+{
+    unsigned int count = GetCount();
+    unsigned int i = 0;
+
+#if defined(SIMD_SSE2) || defined(SIMD_AVX2)
+    TransformArrays arrays = {
+        m_PositionX.data(), m_PositionY.data(), m_PositionZ.data(),
+        m_RotationX.data(), m_RotationY.data(), m_RotationZ.data(), m_RotationW.data(),
+        m_ScaleX.data(), m_ScaleY.data(), m_ScaleZ.data()
+    };
+#if defined(SIMD_AVX2)
+    for (; i + Float8::Width <= count; i += Float8::Width)
+        ComposeBatch<Float8>(arrays, i, viewProjection, m_World.data(), m_MVP.data());
+#endif
+    for (; i + Float4::Width <= count; i += Float4::Width)
+        ComposeBatch<Float4>(arrays, i, viewProjection, m_World.data(), m_MVP.data());
+#endif
+
+    ComposeScalar(i, count, viewProjection);
+}
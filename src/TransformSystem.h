@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+/* Transforms of many objects stored as structure of arrays, so world and
+   MVP matrices of all objects are composed together by one SIMD kernel
+   (4 objects per SSE iteration, 8 per AVX2 iteration). */
+class TransformSystem
+{
+private:
+	// components, one float per object in each array
+	std::vector<float> m_PositionX, m_PositionY, m_PositionZ;
+	std::vector<float> m_RotationX, m_RotationY, m_RotationZ, m_RotationW;
+	std::vector<float> m_ScaleX, m_ScaleY, m_ScaleZ;
+
+	// results of the last Update()
+	std::vector<glm::mat4> m_World;
+	std::vector<glm::mat4> m_MVP;
+
+	void ComposeScalar(unsigned int begin, unsigned int end, const glm::mat4& viewProjection);
+public:
+	/* Adds an object and returns its index */
+	unsigned int Create(const glm::vec3& position, const glm::quat& rotation = glm::quat(), const glm::vec3& scale = glm::vec3(1.0f));
+
+	void SetPosition(unsigned int index, const glm::vec3& position);
+	void SetRotation(unsigned int index, const glm::quat& rotation);
+	void SetScale(unsigned int index, const glm::vec3& scale);
+
+	inline glm::vec3 GetPosition(unsigned int index) const { return glm::vec3(m_PositionX[index], m_PositionY[index], m_PositionZ[index]); }
+	inline glm::vec3 GetScale(unsigned int index) const { return glm::vec3(m_ScaleX[index], m_ScaleY[index], m_ScaleZ[index]); }
+
+	/* Composes world = T * R * S and MVP = viewProjection * world for every object */
+	void Update(const glm::mat4& viewProjection);
+
+	inline const glm::mat4& GetWorld(unsigned int index) const { return m_World[index]; }
+	inline const glm::mat4& GetMVP(unsigned int index) const { return m_MVP[index]; }
+	inline const std::vector<glm::mat4>& GetWorldMatrices() const { return m_World; }
+	inline const std::vector<glm::mat4>& GetMVPMatrices() const { return m_MVP; }
+	inline unsigned int GetCount() const { return (unsigned int)m_PositionX.size(); }
+};
@@ -0,0 +1,54 @@
+#include "UniformBuffer.h"
+#include "Renderer.h"
+
+/* Definition of Uniform Buffer */
+UniformBuffer::UniformBuffer(unsigned int size)
+    : m_Size(size)
+{
+    /* glGenBuffers() generates a buffer object name
+       in [m_RendererID] for the uniform buffer*/
+    GLCall(glGenBuffers(1, &m_RendererID));
+    /* glBindBuffer() binds the buffer object named [m_RendererID]
+       to the [GL_UNIFORM_BUFFER] buffer binding point */
+    GLCall(glBindBuffer(GL_UNIFORM_BUFFER, m_RendererID));
+    /* glBufferData() allocates the data store without initializing it,
+       the contents are written later with SetData() */
+    GLCall(glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW));
+    GLCall(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+}
+
+UniformBuffer::~UniformBuffer()
+{
+    /* glDeleteBuffers() deletes buffer object named [m_RendererID]
+       leaving it without contents, with its name free for reuse */
+    GLCall(glDeleteBuffers(1, &m_RendererID));
+}
+
+void UniformBuffer::SetData(unsigned int offset, const void* data, unsigned int size)
+{
+    ASSERT(offset + size <= m_Size);
+    GLCall(glBindBuffer(GL_UNIFORM_BUFFER, m_RendererID));
+    /* glBufferSubData() updates a subset of the buffer object's data store */
+    GLCall(glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data));
+}
+
+void UniformBuffer::BindRange(unsigned int binding, unsigned int offset, unsigned int size) const
+{
+    /* glBindBufferRange() binds a range of the buffer object named [m_RendererID]
+       to the indexed [binding] of the [GL_UNIFORM_BUFFER] target */
+    GLCall(glBindBufferRange(GL_UNIFORM_BUFFER, binding, m_RendererID, offset, size));
+}
+
+void UniformBuffer::Bind() const
+{
+    /* glBindBuffer() binds the buffer object named [m_RendererID]
+       to the [GL_UNIFORM_BUFFER] buffer binding point */
+    GLCall(glBindBuffer(GL_UNIFORM_BUFFER, m_RendererID));
+}
+
+void UniformBuffer::Unbind() const
+{
+    /* glBindBuffer() unbinds the
+       [GL_UNIFORM_BUFFER] buffer binding point */
+    GLCall(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+class UniformBuffer
+{
+private:
+	unsigned int m_RendererID;
+	unsigned int m_Size;
+public:
+	UniformBuffer(unsigned int size);
+	~UniformBuffer();
+
+	/* Replaces [size] bytes starting at [offset] */
+	void SetData(unsigned int offset, const void* data, unsigned int size);
+	/* Binds the range [offset, offset + size) to uniform block binding point [binding] */
+	void BindRange(unsigned int binding, unsigned int offset, unsigned int size) const;
+
+	void Bind() const;
+	void Unbind() const;
+
+	inline unsigned int GetSize() const { return m_Size; }
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+};
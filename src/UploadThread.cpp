@@ -0,0 +1,156 @@
+#include "UploadThread.h"
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include "IndexBuffer.h"
+#include "Renderer.h"
+#include "Texture.h"
+#include "VertexBuffer.h"
+
+UploadThread::UploadThread(GLFWwindow* sharedWith)
+    : m_Window(nullptr), m_Stop(false), m_Running(false)
+{
+    /* same context hints as [sharedWith], only invisible */
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    m_Window = glfwCreateWindow(1, 1, "Upload", nullptr, sharedWith);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+    if (!m_Window)
+    {
+        std::cout << "Warning: no shared context for the upload thread, uploads run on the calling thread " << std::endl;
+        return;
+    }
+    m_Running = true;
+    m_Thread = std::thread(&UploadThread::Loop, this);
+}
+
+UploadThread::~UploadThread()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_WakeUp.notify_all();
+    if (m_Thread.joinable())
+        m_Thread.join();
+
+    /* nobody waits on these any more, but the futures still get completed,
+       and resources released meanwhile are deleted with this context */
+    Publish();
+    if (m_Window)
+        glfwDestroyWindow(m_Window);
+}
+
+void UploadThread::Loop()
+{
+    glfwMakeContextCurrent(m_Window);
+    while (true)
+    {
+        std::function<void()> work;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_WakeUp.wait(lock, [this]() { return m_Stop || !m_Requests.empty(); });
+            /* the queue is drained before stopping, deletions included */
+            if (m_Requests.empty())
+            {
+                m_Running = false;
+                break;
+            }
+            work = std::move(m_Requests.front());
+            m_Requests.pop_front();
+        }
+        work();
+    }
+    glfwMakeContextCurrent(nullptr);
+}
+
+void UploadThread::Post(std::function<void()> work)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        /* without a running thread the calling thread's context does the work */
+        if (m_Running)
+        {
+            m_Requests.push_back(std::move(work));
+            work = nullptr;
+        }
+    }
+    if (work)
+        work();
+    else
+        m_WakeUp.notify_one();
+}
+
+void UploadThread::Delete(std::function<void()> deletion)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        /* the last reference may go on a thread without any context, so
+           without the upload thread the deletion waits for Publish() */
+        if (!m_Running)
+        {
+            m_Deletions.push_back(std::move(deletion));
+            return;
+        }
+        m_Requests.push_back(std::move(deletion));
+    }
+    m_WakeUp.notify_one();
+}
+
+void UploadThread::Finish(std::function<void()> complete)
+{
+    /* glFenceSync() inserts a fence signaled once the upload commands completed;
+       glFlush() makes sure it reaches the GPU so other contexts can wait on it */
+    GLsync fence = nullptr;
+    GLCall(fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+    GLCall(glFlush());
+
+    std::lock_guard<std::mutex> lock(m_PublishedMutex);
+    m_Published.push_back({ fence, std::move(complete) });
+}
+
+unsigned int UploadThread::Publish()
+{
+    std::vector<Published> published;
+    {
+        std::lock_guard<std::mutex> lock(m_PublishedMutex);
+        published.swap(m_Published);
+    }
+    for (Published& upload : published)
+    {
+        /* glWaitSync() makes the server of this context wait for the fence, the
+           CPU carries on and later commands see the uploaded data */
+        if (upload.fence)
+        {
+            GLCall(glWaitSync(upload.fence, 0, GL_TIMEOUT_IGNORED));
+            GLCall(glDeleteSync(upload.fence));
+        }
+        upload.complete();
+    }
+
+    std::vector<std::function<void()>> deletions;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        deletions.swap(m_Deletions);
+    }
+    for (std::function<void()>& deletion : deletions)
+        deletion();
+    return (unsigned int)published.size();
+}
+
+ResourceFuture<VertexBuffer> UploadThread::UploadVertexBuffer(std::vector<unsigned char> data)
+{
+    auto shared = std::make_shared<std::vector<unsigned char>>(std::move(data));
+    return Upload<VertexBuffer>([shared]() { return new VertexBuffer(shared->data(), (unsigned int)shared->size()); });
+}
+
+ResourceFuture<IndexBuffer> UploadThread::UploadIndexBuffer(std::vector<unsigned int> indices)
+{
+    auto shared = std::make_shared<std::vector<unsigned int>>(std::move(indices));
+    return Upload<IndexBuffer>([shared]() { return new IndexBuffer(shared->data(), (unsigned int)shared->size()); });
+}
+
+ResourceFuture<Texture> UploadThread::UploadTexture(const std::string& path)
+{
+    return Upload<Texture>([path]() { return new Texture(path); });
+}
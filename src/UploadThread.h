@@ -0,0 +1,86 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ResourceFactory.h"
+
+struct GLFWwindow;
+typedef struct __GLsync* GLsync;
+
+/* Thread with its own GL context, shared with the render context, that
+   creates buffers and textures so large uploads never stall rendering.
+   Every finished upload is followed by a fence; Publish() on the render
+   thread makes the render context wait for it on the GPU (glWaitSync, no
+   CPU stall) and only then completes the future. Only shareable objects
+   can be made here: buffers, textures, shaders and programs, not vertex
+   arrays. Resources are deleted on the upload thread as well, or by the
+   next Publish() once the thread stopped, so they may be dropped on any
+   thread; the UploadThread must outlive them. */
+class UploadThread
+{
+private:
+	struct Published
+	{
+		GLsync fence;
+		std::function<void()> complete;
+	};
+
+	GLFWwindow* m_Window;	// hidden, only there for its context
+
+	std::mutex m_Mutex;
+	std::condition_variable m_WakeUp;
+	std::deque<std::function<void()>> m_Requests;
+	// deletions arriving while no upload thread runs, done by Publish()
+	std::vector<std::function<void()>> m_Deletions;
+	bool m_Stop;
+	bool m_Running;
+
+	std::mutex m_PublishedMutex;
+	std::vector<Published> m_Published;
+
+	std::thread m_Thread;
+
+	void Loop();
+	void Post(std::function<void()> work);
+	void Delete(std::function<void()> deletion);
+	void Finish(std::function<void()> complete);
+
+	template<typename T>
+	ResourceFuture<T> Upload(std::function<T*()> create)
+	{
+		auto promise = std::make_shared<std::promise<std::shared_ptr<T>>>();
+		ResourceFuture<T> future = promise->get_future().share();
+		Post([this, promise, create]()
+		{
+			std::shared_ptr<T> resource(create(), [this](T* pointer) { Delete([pointer]() { delete pointer; }); });
+			Finish([promise, resource]() { promise->set_value(resource); });
+		});
+		return future;
+	}
+public:
+	/* Creates the hidden window sharing [sharedWith]'s objects; call on the main thread,
+	   with the window hints [sharedWith] was created with still set */
+	UploadThread(GLFWwindow* sharedWith);
+	/* Call on the main thread with a context of the share group current */
+	~UploadThread();
+
+	UploadThread(const UploadThread&) = delete;
+	UploadThread& operator=(const UploadThread&) = delete;
+
+	ResourceFuture<VertexBuffer> UploadVertexBuffer(std::vector<unsigned char> data);
+	ResourceFuture<IndexBuffer> UploadIndexBuffer(std::vector<unsigned int> indices);
+	/* Decoding happens on the upload thread too */
+	ResourceFuture<Texture> UploadTexture(const std::string& path);
+
+	/* Render thread: queues a GPU wait on the fences of finished uploads and
+	   completes their futures, then deletes the resources released since the
+	   upload thread stopped; returns how many uploads were published */
+	unsigned int Publish();
+};
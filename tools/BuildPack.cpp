@@ -0,0 +1,66 @@
+/* Packs every file below a directory into one asset pack:
+
+       BuildPack res res.pack
+       BuildPack cooked res.pack cooked
+
+   Files keep the paths they are found under ("res/textures/gold.png"),
+   which is what the loaders ask for, so a mounted pack replaces the loose
+   files without code changes. A name root is cut off the front of every
+   path, so the tree written by CookAssets ("cooked/res/textures/gold.ctex")
+   is packed under the names the loaders look for ("res/textures/gold.ctex").
+   The cook database and temporary files left by an interrupted cook are
+   not assets and stay out of the pack. */
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../src/AssetCooker.h"
+#include "../src/AssetPack.h"
+#include "../src/JobSystem.h"
+
+int main(int argc, char** argv)
+{
+    if (argc != 3 && argc != 4)
+    {
+        std::cout << "Usage: BuildPack <asset directory> <output pack> [name root]" << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> files;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(argv[1], error))
+    {
+        if (!entry.is_regular_file())
+            continue;
+        const std::filesystem::path& path = entry.path();
+        if (path.filename() == COOK_DATABASE_NAME || path.extension() == COOK_TEMPORARY_EXTENSION)
+            continue;
+        files.push_back(path.generic_string());
+    }
+    if (error)
+    {
+        std::cout << "Error: can't read ' " << argv[1] << " ' " << std::endl;
+        return 1;
+    }
+    /* sorted so the pack only changes when an asset does */
+    std::sort(files.begin(), files.end());
+
+    JobSystem jobs;
+    auto start = std::chrono::steady_clock::now();
+    if (!AssetPack::Build(files, argv[2], &jobs, argc > 3 ? argv[3] : ""))
+    {
+        std::cout << "Error: building ' " << argv[2] << " ' failed" << std::endl;
+        return 1;
+    }
+    double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    uintmax_t packed = std::filesystem::file_size(argv[2], error);
+    uintmax_t loose = 0;
+    for (const std::string& file : files)
+        loose += std::filesystem::file_size(file, error);
+    std::cout << "Packed " << files.size() << " files, " << loose << " -> " << packed << " bytes in " << milliseconds << " ms" << std::endl;
+    return 0;
+}
@@ -0,0 +1,65 @@
+/* Build step that compiles the shaders into the executable.
+   Every .shader file of a directory is preprocessed (#include resolved),
+   split into stages and written as constexpr string data:
+
+       EmbedShaders res/shaders src/EmbeddedShaders.h
+
+   Run it as a pre-build event whenever res/shaders changes. */
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../src/ShaderPreprocessor.h"
+
+/* Writes [source] as a raw string literal */
+static void WriteLiteral(std::ofstream& out, const std::string& source)
+{
+    out << "R\"glsl(" << source << ")glsl\"";
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        std::cout << "Usage: EmbedShaders <shader directory> <output header>" << std::endl;
+        return 1;
+    }
+
+    std::vector<std::filesystem::path> files;
+    for (const auto& entry : std::filesystem::directory_iterator(argv[1]))
+    {
+        if (entry.is_regular_file() && entry.path().extension() == ".shader")
+            files.push_back(entry.path());
+    }
+    /* sorted so the output only changes when a shader does */
+    std::sort(files.begin(), files.end());
+
+    std::ofstream out(argv[2], std::ios::trunc);
+    if (!out)
+    {
+        std::cout << "Error: can't write ' " << argv[2] << " ' " << std::endl;
+        return 1;
+    }
+    out << "#pragma once\n\n";
+    out << "// Generated by tools/EmbedShaders.cpp from " << std::filesystem::path(argv[1]).generic_string() << ", do not edit\n\n";
+    out << "#include \"ShaderPreprocessor.h\"\n\n";
+    out << "inline constexpr EmbeddedShader g_EmbeddedShaders[] =\n{\n";
+    for (const std::filesystem::path& file : files)
+    {
+        std::vector<std::string> dependencies;
+        std::string text = ShaderPreprocessor::ResolveIncludes(file.generic_string(), dependencies);
+        std::string vertex, fragment;
+        ShaderPreprocessor::SplitStages(text, vertex, fragment);
+
+        out << "\t{\n\t\t\"" << file.stem().string() << "\",\n\t\t";
+        WriteLiteral(out, vertex);
+        out << ",\n\t\t";
+        WriteLiteral(out, fragment);
+        out << "\n\t},\n";
+    }
+    out << "};\n";
+    return 0;
+}
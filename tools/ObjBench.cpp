@@ -0,0 +1,187 @@
+/* Benchmark of the OBJ loader against a plain iostream parser.
+   Without an existing file a grid model of the requested size is written
+   first, with positions, texture coordinates, normals and a few materials:
+
+       ObjBench <model.obj> [megabytes to generate]
+
+   Build it next to src/ObjLoader.cpp, src/MappedFile.cpp and src/JobSystem.cpp. */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../src/JobSystem.h"
+#include "../src/ObjLoader.h"
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static double Milliseconds(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/* A wavy grid of quads, about [megabytes] large */
+static void Generate(const std::string& path, unsigned int megabytes)
+{
+    /* a grid row of n quads costs about 130 bytes per vertex */
+    unsigned int n = (unsigned int)std::sqrt(megabytes * 1024.0 * 1024.0 / 130.0);
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    std::string library = std::filesystem::path(path).stem().string() + ".mtl";
+    out << "mtllib " << library << "\n";
+    out << std::fixed << std::setprecision(6);
+    for (unsigned int y = 0; y <= n; y++)
+    {
+        for (unsigned int x = 0; x <= n; x++)
+        {
+            float u = (float)x / n, v = (float)y / n;
+            float height = 0.1f * std::sin(u * 40.0f) * std::cos(v * 40.0f);
+            out << "v " << u * 100.0f << " " << height << " " << v * 100.0f << "\n";
+            out << "vt " << u << " " << v << "\n";
+            out << "vn " << 0.0f << " " << 1.0f << " " << height << "\n";
+        }
+    }
+    for (unsigned int y = 0; y < n; y++)
+    {
+        if (y % 64 == 0)
+            out << "usemtl band" << (y / 64) % 4 << "\n";
+        for (unsigned int x = 0; x < n; x++)
+        {
+            unsigned int a = y * (n + 1) + x + 1, b = a + 1, c = a + n + 2, d = a + n + 1;
+            out << "f " << a << "/" << a << "/" << a << " " << b << "/" << b << "/" << b << " "
+                << c << "/" << c << "/" << c << " " << d << "/" << d << "/" << d << "\n";
+        }
+    }
+
+    std::ofstream materials((std::filesystem::path(path).parent_path() / library).string(), std::ios::trunc);
+    for (int i = 0; i < 4; i++)
+        materials << "newmtl band" << i << "\nKd " << i * 0.25f << " 0.5 0.5\nmap_Kd band" << i << ".png\n\n";
+}
+
+/* The usual single-threaded approach: getline, stringstream and welding keyed by the corner text */
+static void LoadWithStreams(const std::string& path, MeshData& mesh)
+{
+    std::ifstream in(path);
+    std::vector<glm::vec3> positions, normals;
+    std::vector<glm::vec2> texCoords;
+    std::unordered_map<std::string, unsigned int> welded;
+    std::string line, type, corner;
+    while (std::getline(in, line))
+    {
+        std::istringstream stream(line);
+        stream >> type;
+        if (type == "v")
+        {
+            glm::vec3 p;
+            stream >> p.x >> p.y >> p.z;
+            positions.push_back(p);
+        }
+        else if (type == "vt")
+        {
+            glm::vec2 t;
+            stream >> t.x >> t.y;
+            texCoords.push_back(t);
+        }
+        else if (type == "vn")
+        {
+            glm::vec3 n;
+            stream >> n.x >> n.y >> n.z;
+            normals.push_back(n);
+        }
+        else if (type == "f")
+        {
+            std::vector<unsigned int> face;
+            while (stream >> corner)
+            {
+                auto it = welded.find(corner);
+                if (it == welded.end())
+                {
+                    int v = 0, t = 0, n = 0;
+                    char slash;
+                    std::istringstream parts(corner);
+                    parts >> v >> slash >> t >> slash >> n;
+                    MeshVertex vertex = { positions[v - 1], texCoords[t - 1], normals[n - 1] };
+                    it = welded.emplace(corner, (unsigned int)mesh.vertices.size()).first;
+                    mesh.vertices.push_back(vertex);
+                }
+                face.push_back(it->second);
+            }
+            for (size_t i = 2; i < face.size(); i++)
+                mesh.indices.insert(mesh.indices.end(), { face[0], face[i - 1], face[i] });
+        }
+    }
+}
+
+static bool SameVertex(const MeshVertex& a, const MeshVertex& b)
+{
+    return a.position == b.position && a.texCoord == b.texCoord && a.normal == b.normal;
+}
+
+/* Same triangles corner by corner, whatever order the vertices were welded in */
+static bool SameCorners(const MeshData& a, const MeshData& b)
+{
+    if (a.indices.size() != b.indices.size())
+        return false;
+    for (size_t i = 0; i < a.indices.size(); i++)
+    {
+        if (a.indices[i] >= a.vertices.size() || b.indices[i] >= b.vertices.size() ||
+            !SameVertex(a.vertices[a.indices[i]], b.vertices[b.indices[i]]))
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cout << "Usage: ObjBench <model.obj> [megabytes to generate]" << std::endl;
+        return 1;
+    }
+    std::string path = argv[1];
+    if (!std::filesystem::exists(path))
+    {
+        unsigned int megabytes = argc > 2 ? (unsigned int)std::atoi(argv[2]) : 256;
+        auto start = Clock::now();
+        Generate(path, megabytes);
+        std::cout << "Generated " << path << " in " << Milliseconds(start) << " ms" << std::endl;
+    }
+    double megabytes = std::filesystem::file_size(path) / (1024.0 * 1024.0);
+
+    JobSystem jobs;
+    auto report = [megabytes](const char* name, double milliseconds, const MeshData& mesh)
+    {
+        std::cout << std::left << std::setw(28) << name << std::right << std::setw(10) << std::fixed << std::setprecision(1)
+            << milliseconds << " ms " << std::setw(8) << megabytes / (milliseconds / 1000.0) << " MB/s  "
+            << mesh.vertices.size() << " vertices, " << mesh.indices.size() / 3 << " triangles, " << mesh.parts.size() << " parts" << std::endl;
+    };
+
+    MeshData single, parallel, streams;
+    auto start = Clock::now();
+    ObjLoader::Load(path, single);
+    report("ObjLoader, 1 thread", Milliseconds(start), single);
+
+    start = Clock::now();
+    ObjLoader::Load(path, parallel, &jobs);
+    report(("ObjLoader, " + std::to_string(jobs.GetWorkerCount()) + " threads").c_str(), Milliseconds(start), parallel);
+
+    start = Clock::now();
+    LoadWithStreams(path, streams);
+    report("iostream parser", Milliseconds(start), streams);
+
+    /* welding is sharded the same way on any thread count, so the loader's meshes
+       match exactly; the reference parser welds in file order, so it is compared
+       by the position, texture coordinate and normal of every corner */
+    bool same = single.indices == parallel.indices && single.vertices.size() == parallel.vertices.size() &&
+        std::equal(single.vertices.begin(), single.vertices.end(), parallel.vertices.begin(), SameVertex) &&
+        streams.vertices.size() == parallel.vertices.size() && SameCorners(streams, parallel);
+    std::cout << (same ? "Meshes match" : "Error: meshes differ") << std::endl;
+    return same ? 0 : 1;
+}
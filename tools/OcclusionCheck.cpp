@@ -0,0 +1,86 @@
+/* Regression check of the occlusion culler for objects that occlude
+   themselves, as every frustum-visible cube does in the application.
+   A cube is placed across a range of positions, scales and rotations, added
+   as the only occluder and then tested against the buffer it was drawn
+   into; it must always stay visible. A box behind a wall has to stay
+   hidden, so the check can't pass by culling nothing:
+
+       OcclusionCheck
+
+   Build it next to src/OcclusionCuller.cpp, src/TransformSystem.cpp and src/JobSystem.cpp. */
+
+#include <cmath>
+#include <iostream>
+#include <glm/gtc/matrix_transform.hpp>
+#include "../src/OcclusionCuller.h"
+#include "../src/TransformSystem.h"
+
+/* The application's camera: 45 "degrees" passed as radians, 800x600 */
+static glm::mat4 GetProjection()
+{
+    return glm::perspective(45.0f, 800.0f / 600.0f, 0.1f, 100.0f);
+}
+
+/* Draws the cube as its own occluder the way Application does, true if it survives */
+static bool IsSelfVisible(OcclusionCuller& occlusion, const glm::vec3& position, const glm::quat& rotation, float scale)
+{
+    const AABB cubeBounds = { glm::vec3(-0.5f), glm::vec3(0.5f) };
+    glm::mat4 projection = GetProjection();
+    TransformSystem transforms;
+    unsigned int cube = transforms.Create(position, rotation, glm::vec3(scale));
+    transforms.Update(projection);
+
+    occlusion.Begin();
+    occlusion.AddOccluder(cubeBounds, transforms.GetMVP(cube));
+    occlusion.Rasterize();
+    return occlusion.IsVisible(TransformAABB(cubeBounds, transforms.GetWorld(cube)), projection);
+}
+
+int main()
+{
+    OcclusionCuller occlusion;
+    unsigned int tested = 0, failed = 0;
+    auto check = [&](const glm::vec3& position, const glm::quat& rotation, float scale)
+    {
+        tested++;
+        if (IsSelfVisible(occlusion, position, rotation, scale))
+            return;
+        if (failed++ < 10)
+        {
+            std::cout << "Error: cube at " << position.x << " " << position.y << " " << position.z
+                << ", scale " << scale << " hides itself" << std::endl;
+        }
+    };
+
+    /* unrotated cubes are where the box and its own front face have the same depth */
+    const float scales[] = { 0.5f, 0.73f, 1.0f, 1.5f };
+    for (float scale : scales)
+    {
+        for (int i = -100; i <= 100; i++)
+        {
+            for (int z = 0; z < 3; z++)
+                check(glm::vec3(i * 0.01f, 0.0f, -3.0f - z * 2.0f), glm::quat(), scale);
+        }
+    }
+    check(glm::vec3(0.4f, 0.0f, -3.0f), glm::quat(), 1.0f);
+
+    /* and the application's animation, close to identity and away from it */
+    glm::vec3 axis = glm::normalize(glm::vec3(0.5f, 1.0f, 0.0f));
+    for (int i = 0; i < 2000; i++)
+    {
+        float angle = i * 0.0031415927f;
+        check(glm::vec3(std::sin(i * 0.01f), 0.0f, -3.0f), glm::angleAxis(angle, axis), 0.5f + (i % 50) * 0.01f);
+    }
+
+    /* a wall still hides what is behind it */
+    glm::mat4 projection = GetProjection();
+    occlusion.Begin();
+    occlusion.AddOccluder(AABB{ glm::vec3(-5.0f, -5.0f, -11.0f), glm::vec3(5.0f, 5.0f, -10.0f) }, projection);
+    occlusion.Rasterize();
+    bool hidden = !occlusion.IsVisible(AABB{ glm::vec3(-1.0f, -1.0f, -21.0f), glm::vec3(1.0f, 1.0f, -20.0f) }, projection);
+    if (!hidden)
+        std::cout << "Error: a box behind the wall is visible" << std::endl;
+
+    std::cout << tested << " cubes, " << failed << " hid themselves" << std::endl;
+    return failed == 0 && hidden ? 0 : 1;
+}
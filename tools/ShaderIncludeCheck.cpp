@@ -0,0 +1,57 @@
+/* Regression check of #include resolution in .shader files.
+   A file included by both the vertex and the fragment stage has to reach
+   both of them, while a file included twice within one stage still only
+   appears once in it:
+
+       ShaderIncludeCheck
+
+   Build it next to src/ShaderPreprocessor.cpp. */
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../src/ShaderPreprocessor.h"
+
+static size_t Count(const std::string& text, const std::string& pattern)
+{
+    size_t count = 0;
+    for (size_t at = text.find(pattern); at != std::string::npos; at = text.find(pattern, at + 1))
+        count++;
+    return count;
+}
+
+int main()
+{
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "ShaderIncludeCheck";
+    std::filesystem::create_directories(directory);
+    std::ofstream(directory / "Common.glsl") << "float Common() { return 1.0; }\n";
+    std::ofstream(directory / "Lighting.glsl") << "#include \"Common.glsl\"\nfloat Lighting() { return Common(); }\n";
+    std::ofstream(directory / "Test.shader")
+        << "#shader vertex\n#version 330 core\n#include \"Common.glsl\"\nvoid main() {}\n"
+        << "#shader fragment\n#version 330 core\n#include \"Common.glsl\"\n#include \"Lighting.glsl\"\nvoid main() {}\n";
+
+    std::vector<std::string> dependencies;
+    std::string text = ShaderPreprocessor::ResolveIncludes((directory / "Test.shader").generic_string(), dependencies);
+    std::string vertex, fragment;
+    ShaderPreprocessor::SplitStages(text, vertex, fragment);
+
+    bool passed = true;
+    auto expect = [&passed](bool condition, const char* message)
+    {
+        if (!condition)
+        {
+            std::cout << "Error: " << message << std::endl;
+            passed = false;
+        }
+    };
+    expect(Count(vertex, "float Common()") == 1, "the vertex stage doesn't have Common.glsl once");
+    expect(Count(fragment, "float Common()") == 1, "the fragment stage doesn't have Common.glsl once");
+    expect(Count(fragment, "float Lighting()") == 1, "the fragment stage doesn't have Lighting.glsl");
+    expect(dependencies.size() == 3, "every file should be a dependency exactly once");
+
+    std::filesystem::remove_all(directory);
+    std::cout << (passed ? "Includes resolved per stage" : "Error: include resolution is broken") << std::endl;
+    return passed ? 0 : 1;
+}
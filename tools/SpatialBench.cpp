@@ -0,0 +1,146 @@
+/* Benchmark of the spatial structures under moving objects.
+   A field of boxes is animated with a growing share of them moving every
+   frame; per frame the BVH is refit (or rebuilt) and the grid updated,
+   then both answer the same frustum and box queries:
+
+       SpatialBench [object count] [frames]
+
+   Build it next to src/BVH.cpp, src/SpatialGrid.cpp and src/Frustum.cpp. */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+#include "../src/BVH.h"
+#include "../src/Frustum.h"
+#include "../src/SpatialGrid.h"
+
+/* World is a cube of this half size, objects are unit boxes */
+#define BENCH_WORLD_SIZE 200.0f
+#define BENCH_QUERIES 64
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static double Milliseconds(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static AABB MakeBox(const glm::vec3& center)
+{
+    return { center - glm::vec3(0.5f), center + glm::vec3(0.5f) };
+}
+
+int main(int argc, char** argv)
+{
+    unsigned int count = argc > 1 ? (unsigned int)std::atoi(argv[1]) : 20000;
+    unsigned int frames = argc > 2 ? (unsigned int)std::atoi(argv[2]) : 60;
+
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> position(-BENCH_WORLD_SIZE, BENCH_WORLD_SIZE);
+    std::uniform_real_distribution<float> velocity(-1.0f, 1.0f);
+
+    std::vector<glm::vec3> startCenters(count), velocities(count);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        startCenters[i] = glm::vec3(position(random), position(random), position(random));
+        velocities[i] = glm::vec3(velocity(random), velocity(random), velocity(random));
+    }
+
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, BENCH_WORLD_SIZE);
+    std::vector<AABB> queryBoxes;
+    for (int q = 0; q < BENCH_QUERIES; q++)
+    {
+        glm::vec3 center(position(random), position(random), position(random));
+        queryBoxes.push_back({ center - glm::vec3(10.0f), center + glm::vec3(10.0f) });
+    }
+
+    std::cout << "objects " << count << ", frames " << frames << ", times in ms per frame" << std::endl;
+    std::cout << "moving  bvh refit  bvh rebuild  grid update  bvh query  grid query" << std::endl;
+
+    const float dynamism[] = { 0.0f, 0.01f, 0.1f, 0.5f, 1.0f };
+    for (float share : dynamism)
+    {
+        std::vector<glm::vec3> centers = startCenters;
+        std::vector<AABB> bounds(count);
+        for (unsigned int i = 0; i < count; i++)
+            bounds[i] = MakeBox(centers[i]);
+
+        BVH refitted, rebuilt;
+        refitted.Build(bounds);
+        SpatialGrid grid(8.0f);
+        for (const AABB& box : bounds)
+            grid.Insert(box);
+
+        unsigned int moving = (unsigned int)(share * count);
+        double refitTime = 0.0, rebuildTime = 0.0, gridTime = 0.0, bvhQueryTime = 0.0, gridQueryTime = 0.0;
+        /* the frustum result first, then one per query box */
+        std::vector<std::vector<unsigned int>> bvhResults(BENCH_QUERIES + 1), gridResults(BENCH_QUERIES + 1);
+        bool mismatch = false;
+
+        for (unsigned int frame = 0; frame < frames; frame++)
+        {
+            for (unsigned int i = 0; i < moving; i++)
+            {
+                centers[i] += velocities[i];
+                bounds[i] = MakeBox(centers[i]);
+            }
+
+            auto start = Clock::now();
+            refitted.Refit(bounds);
+            refitTime += Milliseconds(start);
+
+            start = Clock::now();
+            rebuilt.Build(bounds);
+            rebuildTime += Milliseconds(start);
+
+            start = Clock::now();
+            for (unsigned int i = 0; i < moving; i++)
+                grid.Update(i, bounds[i]);
+            gridTime += Milliseconds(start);
+
+            float angle = frame * 0.05f;
+            glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(std::cos(angle), 0.0f, std::sin(angle)), glm::vec3(0.0f, 1.0f, 0.0f));
+            Frustum frustum(projection * view);
+
+            /* the refitted tree is the one that degrades, so it is the one queried */
+            start = Clock::now();
+            refitted.Query(frustum, bvhResults[0]);
+            for (int q = 0; q < BENCH_QUERIES; q++)
+                refitted.Query(queryBoxes[q], bvhResults[q + 1]);
+            bvhQueryTime += Milliseconds(start);
+
+            start = Clock::now();
+            grid.Query(frustum, gridResults[0]);
+            for (int q = 0; q < BENCH_QUERIES; q++)
+                grid.Query(queryBoxes[q], gridResults[q + 1]);
+            gridQueryTime += Milliseconds(start);
+
+            /* both structures must report the same objects, in whatever order */
+            for (int q = 0; q <= BENCH_QUERIES; q++)
+            {
+                std::sort(bvhResults[q].begin(), bvhResults[q].end());
+                std::sort(gridResults[q].begin(), gridResults[q].end());
+                if (bvhResults[q] != gridResults[q])
+                    mismatch = true;
+            }
+        }
+
+        std::cout << std::fixed << std::setprecision(3)
+            << std::setw(5) << (int)(share * 100.0f) << "%"
+            << std::setw(11) << refitTime / frames
+            << std::setw(13) << rebuildTime / frames
+            << std::setw(13) << gridTime / frames
+            << std::setw(11) << bvhQueryTime / frames
+            << std::setw(12) << gridQueryTime / frames;
+        if (mismatch)
+            std::cout << "  mismatch";
+        std::cout << std::endl;
+    }
+    return 0;
+}